@@ -0,0 +1,383 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* cJSON benchmark */
+/* Generates repeatable corpora in memory, times the library against them and reports the results as JSON. */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "cJSON_Utils.h"
+
+/* Allocation counting hooks. */
+static long allocs,frees;
+static size_t alloc_bytes;
+static void *count_malloc(size_t sz)	{allocs++;alloc_bytes+=sz;return malloc(sz);}
+static void count_free(void *ptr)		{if (ptr) frees++;free(ptr);}
+static void reset_counts(void)			{allocs=frees=0;alloc_bytes=0;}
+
+static double now(void) {struct timespec ts;clock_gettime(CLOCK_MONOTONIC,&ts);return ts.tv_sec+ts.tv_nsec*1e-9;}
+
+/* A tiny deterministic generator, so every run sees the same corpora. */
+static unsigned long rng_state;
+static void rng_seed(unsigned long s)	{rng_state=s;}
+static unsigned rng(void)				{rng_state=rng_state*6364136223846793005UL+1442695040888963407UL;return (unsigned)(rng_state>>33);}
+static double rng_unit(void)			{return rng()/2147483648.0;}
+
+/* Growable text buffer for the generators. */
+typedef struct {char *data;size_t len,cap;} buffer;
+static void buf_printf(buffer *b,const char *fmt,...)
+{
+	va_list ap;int n;
+	for (;;)
+	{
+		va_start(ap,fmt);n=vsnprintf(b->data+b->len,b->cap-b->len,fmt,ap);va_end(ap);
+		if (n>=0 && (size_t)n<b->cap-b->len) {b->len+=n;return;}
+		b->cap=b->cap*2+(n>0?n:64)+1;b->data=(char*)realloc(b->data,b->cap);
+		if (!b->data) {fprintf(stderr,"out of memory\n");exit(1);}
+	}
+}
+
+static const char *words[]={"the","quick","brown","fox","jumps","over","lazy","dog","caf\\u00e9","\\\"quoted\\\"","line\\nbreak","tab\\there","na\\u00efve","\\ud83d\\ude00","json","parser","stream","token"};
+#define NWORDS ((int)(sizeof(words)/sizeof(*words)))
+
+/* Number heavy: a GeoJSON-like collection of polygons. */
+static void gen_geo(buffer *b,int scale)
+{
+	int f,p,features=40*scale;
+	buf_printf(b,"{\"type\":\"FeatureCollection\",\"features\":[");
+	for (f=0;f<features;f++)
+	{
+		buf_printf(b,"%s{\"type\":\"Feature\",\"properties\":{\"name\":\"region-%d\",\"id\":%d},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[",f?",":"",f,f);
+		for (p=0;p<100;p++) buf_printf(b,"%s[%.6f,%.6f]",p?",":"",-180.0+360.0*rng_unit(),-90.0+180.0*rng_unit());
+		buf_printf(b,"]]}}");
+	}
+	buf_printf(b,"]}");
+}
+
+/* String heavy: a feed of posts with escapes and unicode. */
+static void gen_social(buffer *b,int scale)
+{
+	int i,w,posts=400*scale;
+	buf_printf(b,"{\"statuses\":[");
+	for (i=0;i<posts;i++)
+	{
+		buf_printf(b,"%s{\"id\":%d,\"user\":{\"screen_name\":\"user_%u\",\"name\":\"User %u\",\"verified\":%s},\"text\":\"",i?",":"",i,rng()%10000,rng()%10000,(rng()&1)?"true":"false");
+		for (w=0;w<30;w++) buf_printf(b,"%s%s",w?" ":"",words[rng()%NWORDS]);
+		buf_printf(b,"\",\"lang\":\"en\",\"retweeted\":false,\"source\":\"<a href=\\\"http://example.com/\\\">web</a>\",\"tags\":[\"%s\",\"%s\"]}",words[rng()%NWORDS],words[rng()%NWORDS]);
+	}
+	buf_printf(b,"]}");
+}
+
+/* Deeply nested: chains of alternating objects and arrays. */
+static void gen_nested(buffer *b,int scale)
+{
+	int c,d,chains=40*scale,depth=200;
+	buf_printf(b,"[");
+	for (c=0;c<chains;c++)
+	{
+		buf_printf(b,"%s",c?",":"");
+		for (d=0;d<depth;d++) buf_printf(b,(d&1)?"[%d,":"{\"k%d\":",d);
+		buf_printf(b,"null");
+		for (d=depth-1;d>=0;d--) buf_printf(b,(d&1)?"]":"}");
+	}
+	buf_printf(b,"]");
+}
+
+/* Wide: one flat object with many members. */
+static void gen_wide(buffer *b,int scale)
+{
+	int i,n=2000*scale;
+	buf_printf(b,"{");
+	for (i=0;i<n;i++) buf_printf(b,"%s\"key_%d\":%u",i?",":"",i,rng()%100000);
+	buf_printf(b,"}");
+}
+
+/* NDJSON: many small documents, one per line. */
+static void gen_ndjson(buffer *b,int scale)
+{
+	int i,n=2000*scale;
+	for (i=0;i<n;i++) buf_printf(b,"{\"ts\":%d,\"level\":\"%s\",\"msg\":\"%s %s\",\"latency\":%.3f,\"ok\":%s}\n",
+		1400000000+i,(rng()&1)?"info":"warn",words[rng()%NWORDS],words[rng()%NWORDS],rng_unit()*100.0,(rng()&3)?"true":"false");
+}
+
+typedef struct {const char *name;void (*gen)(buffer *b,int scale);const char *lookup;int ndjson;const char *path;} corpus;
+static const corpus corpora[]={
+	{"geo",gen_geo,"type",0,"/features/39/properties/name"},
+	{"social",gen_social,"statuses",0,"/statuses/399/user/screen_name"},
+	{"nested",gen_nested,0,0,"/39/k0/1/k2/1/k4"},
+	{"wide",gen_wide,"key_0",0,"/key_1999"},
+	{"ndjson",gen_ndjson,0,1,"/1999/msg"},
+};
+
+/* Parse a whole corpus. For NDJSON the documents are chained into one array so the other operations see them all;
+they are linked on at a tail pointer, as cJSON_AddItemToArray would walk the whole chain each time. */
+static cJSON *parse_corpus(const corpus *c,const char *text,int flags)
+{
+	const char *end;cJSON *root,*doc,*tail=0;
+	if (!c->ndjson) return cJSON_ParseWithFlags(text,0,flags);
+	root=cJSON_CreateArray();
+	while (*text)
+	{
+		if (!(doc=cJSON_ParseWithFlags(text,&end,flags))) break;
+		if (tail) tail->next=doc,doc->prev=tail; else root->child=doc;
+		doc->parent=root;tail=doc;
+		text=end;while (*text=='\n' || *text=='\r') text++;
+	}
+	return root;
+}
+
+/* Fixed-shape messages: the NDJSON lines bound straight into a struct, against parsing each and copying its members out. */
+typedef struct {int ts;char level[8];char *msg;double latency;int ok;} log_line;
+static const cJSON_Field log_fields[]={
+	cJSON_BindField(log_line,ts,cJSON_BindInt),cJSON_BindField(log_line,level,cJSON_BindChars),cJSON_BindField(log_line,msg,cJSON_BindString),
+	cJSON_BindField(log_line,latency,cJSON_BindDouble),cJSON_BindField(log_line,ok,cJSON_BindBool),cJSON_BindEnd};
+
+static int bind_lines(cJSON_Schema *s,const char *text)
+{
+	const char *end;log_line l;int n=0;
+	while (*text)
+	{
+		if (!(end=strchr(text,'\n'))) end=text+strlen(text);
+		memset(&l,0,sizeof(l));
+		if (!cJSON_ParseInto(s,text,end-text,&l)) n++;
+		cJSON_FreeBound(s,&l);
+		text=*end?end+1:end;
+	}
+	return n;
+}
+static int extract_lines(const char *text)
+{
+	const char *end;log_line l;cJSON *doc,*item;int n=0;
+	while (*text)
+	{
+		if (!(doc=cJSON_ParseWithOpts(text,&end,0))) break;
+		memset(&l,0,sizeof(l));
+		if ((item=cJSON_GetObjectItem(doc,"ts")))								l.ts=item->valueint;
+		if ((item=cJSON_GetObjectItem(doc,"level")) && item->type==cJSON_String)		strncpy(l.level,item->valuestring,sizeof(l.level)-1);
+		if ((item=cJSON_GetObjectItem(doc,"msg")) && item->type==cJSON_String)			{l.msg=(char*)malloc(strlen(item->valuestring)+1);strcpy(l.msg,item->valuestring);}
+		if ((item=cJSON_GetObjectItem(doc,"latency")))							l.latency=item->valuedouble;
+		if ((item=cJSON_GetObjectItem(doc,"ok")))								l.ok=item->type==cJSON_True;
+		free(l.msg);cJSON_Delete(doc);n++;
+		text=end;while (*text=='\n' || *text=='\r') text++;
+	}
+	return n;
+}
+
+static double min_time=0.25;
+
+/* Time each operation until at least min_time has elapsed, and return the best seconds per iteration. */
+#define TIME_OP(best,setup,op,teardown) do{double t0,t1,total=0;int it=0;best=1e30;\
+	while (total<min_time || it<3) {setup;t0=now();op;t1=now();teardown;total+=t1-t0;if (t1-t0<best) best=t1-t0;it++;}}while(0)
+
+static double mbps(size_t bytes,double secs)	{return secs>0?bytes/secs/1048576.0:0;}
+
+/* The change made before each cached re-print: follow the first array/object member down as far as it goes, and
+replace the first value there with a new number. */
+static void edit_leaf(cJSON *item)
+{
+	static int edits;cJSON *c;
+	for (;;)
+	{
+		for (c=item->child;c && (c->type&255)!=cJSON_Array && (c->type&255)!=cJSON_Object;c=c->next);
+		if (!c) break;
+		item=c;
+	}
+	if (!item->child) return;
+	if ((item->type&255)==cJSON_Object) cJSON_ReplaceItemInObject(item,item->child->string,cJSON_CreateNumber(++edits));
+	else cJSON_ReplaceItemInArray(item,0,cJSON_CreateNumber(++edits));
+}
+
+static cJSON *run_corpus(const corpus *c,int scale)
+{
+	buffer b={0,0,0};char *copy,*out=0;cJSON *json=0,*dup=0,*res,*allo;double t;size_t len;int i,lookups;
+
+	rng_seed(0x5eed+scale);c->gen(&b,scale);
+	len=b.len;copy=(char*)malloc(len+1);
+	res=cJSON_CreateObject();
+	cJSON_AddNumberToObject(res,"bytes",len);
+
+	TIME_OP(t,,json=parse_corpus(c,b.data,0),cJSON_Delete(json));
+	cJSON_AddNumberToObject(res,"parse_mbps",mbps(len,t));
+	TIME_OP(t,,json=parse_corpus(c,b.data,cJSON_ParsePackNumbers),cJSON_Delete(json));
+	cJSON_AddNumberToObject(res,"parse_packed_mbps",mbps(len,t));
+
+	json=parse_corpus(c,b.data,0);
+	if (!json) {fprintf(stderr,"%s: parse failed near [%.20s]\n",c->name,cJSON_GetErrorPtr());exit(1);}
+
+	TIME_OP(t,,out=cJSON_Print(json),free(out));
+	cJSON_AddNumberToObject(res,"print_mbps",mbps(len,t));
+	TIME_OP(t,,out=cJSON_PrintUnformatted(json),free(out));
+	cJSON_AddNumberToObject(res,"print_unformatted_mbps",mbps(len,t));
+	/* Re-printing with cJSON_PrintCached after a change deep under the first member: only that path is rendered again. */
+	cJSON_Delete(dup);dup=cJSON_Duplicate(json,1);
+	out=cJSON_PrintWithOpts(dup,cJSON_PrintCached);free(out);
+	TIME_OP(t,edit_leaf(dup),out=cJSON_PrintWithOpts(dup,cJSON_PrintCached),free(out));
+	cJSON_AddNumberToObject(res,"reprint_cached_mbps",mbps(len,t));
+	cJSON_Delete(dup);dup=0;
+	TIME_OP(t,memcpy(copy,b.data,len+1),cJSON_Minify(copy),);
+	cJSON_AddNumberToObject(res,"minify_mbps",mbps(len,t));
+	TIME_OP(t,,dup=cJSON_Duplicate(json,1),cJSON_Delete(dup));
+	cJSON_AddNumberToObject(res,"duplicate_mbps",mbps(len,t));
+	/* A shared duplicate takes constant time whatever the size, so it is timed per call. */
+	TIME_OP(t,,dup=cJSON_DuplicateShared(json),cJSON_Delete(dup));
+	cJSON_AddNumberToObject(res,"duplicate_shared_ns",t*1e9);
+	TIME_OP(t,dup=cJSON_Duplicate(json,1),cJSON_Delete(dup),);
+	cJSON_AddNumberToObject(res,"delete_mbps",mbps(len,t));
+
+	/* Lookups: the last key of the root object is the worst case for the linear member scan. */
+	if (c->lookup && json->child)
+	{
+		cJSON *last=json->child;const char *key;
+		while (last->next) last=last->next;
+		key=(json->type==cJSON_Object)?last->string:c->lookup;
+		lookups=10000;
+		TIME_OP(t,,for (i=0;i<lookups;i++) if (!cJSON_GetObjectItem(json,key)) break,);
+		cJSON_AddNumberToObject(res,"lookup_ns",t*1e9/lookups);
+	}
+
+	if (c->ndjson)
+	{
+		cJSON_Schema *schema=cJSON_CompileSchema(log_fields);
+		TIME_OP(t,,bind_lines(schema,b.data),);
+		cJSON_AddNumberToObject(res,"bind_parse_mbps",mbps(len,t));
+		TIME_OP(t,,extract_lines(b.data),);
+		cJSON_AddNumberToObject(res,"dom_extract_mbps",mbps(len,t));
+		cJSON_DeleteSchema(schema);
+	}
+
+	/* Deep lookups: a pointer walked afresh each time, against the same path compiled once. */
+	if (c->path)
+	{
+		cJSON_Path *path=cJSON_CompilePath(c->path);cJSON *found;
+		lookups=10000;
+		TIME_OP(t,,for (i=0;i<lookups;i++) if (!cJSON_GetPointer(json,c->path)) break,);
+		cJSON_AddNumberToObject(res,"pointer_ns",t*1e9/lookups);
+		TIME_OP(t,,for (i=0;i<lookups;i++) if (!cJSON_QueryCompiled(json,path,&found,1)) break,);
+		cJSON_AddNumberToObject(res,"query_compiled_ns",t*1e9/lookups);
+		cJSON_DeletePath(path);
+	}
+
+	/* Allocation counts for one parse and one print of the corpus. */
+	allo=cJSON_CreateObject();
+	cJSON_Delete(json);
+	reset_counts();json=parse_corpus(c,b.data,0);
+	cJSON_AddNumberToObject(allo,"parse_allocs",allocs);
+	cJSON_AddNumberToObject(allo,"parse_alloc_bytes",alloc_bytes);
+	reset_counts();out=cJSON_PrintUnformatted(json);
+	cJSON_AddNumberToObject(allo,"print_allocs",allocs);
+	cJSON_AddNumberToObject(allo,"print_alloc_bytes",alloc_bytes);
+	free(out);
+	reset_counts();cJSON_Delete(json);
+	cJSON_AddNumberToObject(allo,"delete_frees",frees);
+	cJSON_AddItemToObject(res,"allocations",allo);
+
+	free(copy);free(b.data);
+	return res;
+}
+
+static char *read_file(const char *filename)
+{
+	FILE *f=fopen(filename,"rb");long len;char *data;
+	if (!f) return 0;
+	fseek(f,0,SEEK_END);len=ftell(f);fseek(f,0,SEEK_SET);
+	data=(char*)malloc(len+1);
+	if (data) {data[fread(data,1,len,f)]=0;}
+	fclose(f);
+	return data;
+}
+
+/* Annotate every numeric result with its ratio against the same entry in a stored baseline run. */
+static void compare(cJSON *run,cJSON *base)
+{
+	cJSON *r,*b;
+	for (r=run->child;r;r=r->next)
+	{
+		if (!r->string || !(b=cJSON_GetObjectItem(base,r->string))) continue;
+		if (r->type==cJSON_Object && b->type==cJSON_Object) compare(r,b);
+		else if (r->type==cJSON_Number && b->type==cJSON_Number && b->valuedouble!=0 && !strstr(r->string,"_vs_baseline"))
+		{
+			char name[128];
+			snprintf(name,sizeof(name),"%s_vs_baseline",r->string);
+			cJSON_AddNumberToObject(run,name,r->valuedouble/b->valuedouble);
+		}
+	}
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,"usage: %s [-s scale] [-t seconds] [-c corpus] [-b baseline.json] [-o output.json]\n",prog);
+	exit(1);
+}
+
+int main(int argc,const char *argv[])
+{
+	cJSON_Hooks hooks={count_malloc,count_free};
+	const char *only=0,*baseline=0,*output=0;
+	cJSON *root,*results,*base,*prev;
+	struct rusage ru;char *out,*text;int i,scale=1;
+
+	for (i=1;i<argc;i++)
+	{
+		if (!strcmp(argv[i],"-s") && i+1<argc)		scale=atoi(argv[++i]);
+		else if (!strcmp(argv[i],"-t") && i+1<argc)	min_time=atof(argv[++i]);
+		else if (!strcmp(argv[i],"-c") && i+1<argc)	only=argv[++i];
+		else if (!strcmp(argv[i],"-b") && i+1<argc)	baseline=argv[++i];
+		else if (!strcmp(argv[i],"-o") && i+1<argc)	output=argv[++i];
+		else usage(argv[0]);
+	}
+	if (scale<1) scale=1;
+
+	cJSON_InitHooks(&hooks);
+	root=cJSON_CreateObject();
+	cJSON_AddNumberToObject(root,"scale",scale);
+	cJSON_AddItemToObject(root,"results",results=cJSON_CreateObject());
+	for (i=0;i<(int)(sizeof(corpora)/sizeof(*corpora));i++)
+	{
+		if (only && strcmp(only,corpora[i].name)) continue;
+		cJSON_AddItemToObject(results,corpora[i].name,run_corpus(&corpora[i],scale));
+	}
+	getrusage(RUSAGE_SELF,&ru);
+	cJSON_AddNumberToObject(root,"peak_rss_kb",ru.ru_maxrss);
+
+	if (baseline)
+	{
+		if (!(text=read_file(baseline)) || !(base=cJSON_Parse(text))) {fprintf(stderr,"cannot read baseline %s\n",baseline);return 1;}
+		if ((prev=cJSON_GetObjectItem(base,"results"))) compare(results,prev);
+		cJSON_Delete(base);free(text);
+	}
+
+	out=cJSON_Print(root);
+	if (output)
+	{
+		FILE *f=fopen(output,"wb");
+		if (!f) {fprintf(stderr,"cannot write %s\n",output);return 1;}
+		fprintf(f,"%s\n",out);fclose(f);
+	}
+	else printf("%s\n",out);
+	free(out);cJSON_Delete(root);
+	return 0;
+}
@@ -30,6 +30,11 @@
 #include <float.h>
 #include <limits.h>
 #include <ctype.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "cJSON.h"
 
 static const char *ep;
@@ -46,6 +51,82 @@ static int cJSON_strcasecmp(const char *s1,const char *s2)
 static void *(*cJSON_malloc)(size_t sz) = malloc;
 static void (*cJSON_free)(void *ptr) = free;
 
+/* Statistics. Compiled out unless CJSON_STATS is defined; STAT() wraps every bit of bookkeeping. */
+#ifdef CJSON_STATS
+#include <time.h>
+#if defined(__GNUC__)
+#define CJSON_THREAD __thread
+#elif defined(_MSC_VER)
+#define CJSON_THREAD __declspec(thread)
+#else
+#define CJSON_THREAD
+#endif
+static CJSON_THREAD cJSON_Stats stats;
+static CJSON_THREAD int stats_depth;
+static double stats_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;clock_gettime(CLOCK_MONOTONIC,&ts);return ts.tv_sec+ts.tv_nsec*1e-9;
+#else
+	return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+/* The size of every block handed out through the hooks, so a free can be counted with its bytes. An open-addressed
+table keyed by address, kept with plain malloc per thread and freed whenever it empties. A block it does not hold - one
+it could not take on memory fail, or one allocated on another thread or before cJSON_ResetStats - is counted when freed
+without its bytes. */
+typedef struct {void *ptr;size_t size;} stats_block;
+static CJSON_THREAD stats_block *blocks;
+static CJSON_THREAD size_t blocks_mask,blocks_used;
+static void blocks_drop(void)		{free(blocks);blocks=0;blocks_mask=blocks_used=0;}
+static size_t block_slot(void *ptr)	{return ((size_t)ptr>>4)*2654435761u&blocks_mask;}
+static void block_put(void *ptr,size_t size)
+{
+	stats_block *old=blocks;size_t i,oldsize=old?blocks_mask+1:0;
+	if ((blocks_used+1)*2>oldsize)
+	{
+		if (!(blocks=(stats_block*)malloc((oldsize?oldsize*2:1024)*sizeof(stats_block)))) {blocks=old;if (!old || blocks_used+1>blocks_mask) return;}
+		else
+		{
+			blocks_mask=(oldsize?oldsize*2:1024)-1;blocks_used=0;
+			memset(blocks,0,(blocks_mask+1)*sizeof(stats_block));
+			for (i=0;i<oldsize;i++) if (old[i].ptr) block_put(old[i].ptr,old[i].size);
+			free(old);
+		}
+	}
+	for (i=block_slot(ptr);blocks[i].ptr && blocks[i].ptr!=ptr;i=(i+1)&blocks_mask);
+	if (!blocks[i].ptr) blocks_used++;
+	blocks[i].ptr=ptr;blocks[i].size=size;
+}
+static size_t block_take(void *ptr)
+{
+	size_t i,j,k,size;
+	if (!blocks) return 0;
+	for (i=block_slot(ptr);blocks[i].ptr!=ptr;i=(i+1)&blocks_mask) if (!blocks[i].ptr) return 0;
+	size=blocks[i].size;
+	/* Shift later entries of the run back into the hole, so lookups never stop short. */
+	for (j=i;blocks[j=(j+1)&blocks_mask].ptr;)
+	{
+		k=block_slot(blocks[j].ptr);
+		if ((j>i)?(k<=i || k>j):(k<=i && k>j)) {blocks[i]=blocks[j];i=j;}
+	}
+	blocks[i].ptr=0;
+	if (!--blocks_used) blocks_drop();
+	return size;
+}
+static void *stats_malloc(size_t sz)	{void *ptr=cJSON_malloc(sz);if (ptr) stats.allocs++,stats.alloc_bytes+=sz,block_put(ptr,sz);return ptr;}
+static void stats_free(void *ptr)		{if (ptr) stats.frees++,stats.free_bytes+=block_take(ptr);cJSON_free(ptr);}
+#define cJSON_malloc stats_malloc
+#define cJSON_free stats_free
+#define STAT(x) x
+void cJSON_GetStats(cJSON_Stats *out)	{if (out) *out=stats;}
+void cJSON_ResetStats(void)				{memset(&stats,0,sizeof(stats));blocks_drop();}
+#else
+#define STAT(x)
+void cJSON_GetStats(cJSON_Stats *out)	{if (out) memset(out,0,sizeof(cJSON_Stats));}
+void cJSON_ResetStats(void)				{}
+#endif
+
 static char* cJSON_strdup(const char* str)
 {
       size_t len;
@@ -57,6 +138,8 @@ static char* cJSON_strdup(const char* str)
       return copy;
 }
 
+#undef cJSON_malloc
+#undef cJSON_free
 void cJSON_InitHooks(cJSON_Hooks* hooks)
 {
     if (!hooks) { /* Reset hooks */
@@ -68,6 +151,13 @@ void cJSON_InitHooks(cJSON_Hooks* hooks)
 	cJSON_malloc = (hooks->malloc_fn)?hooks->malloc_fn:malloc;
 	cJSON_free	 = (hooks->free_fn)?hooks->free_fn:free;
 }
+#ifdef CJSON_STATS
+#define cJSON_malloc stats_malloc
+#define cJSON_free stats_free
+#endif
+
+void *cJSON_Malloc(size_t sz)	{return cJSON_malloc(sz);}
+void cJSON_Free(void *ptr)		{if (ptr) cJSON_free(ptr);}
 
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(void)
@@ -77,15 +167,28 @@ static cJSON *cJSON_New_Item(void)
 	return node;
 }
 
+/* Where cJSON_PrintCached keeps an array/object's text. Text that its parent's kept text holds is not copied again: it is
+the slice len bytes long at off in that (placed). Only the top of what is kept has a buffer of its own. */
+struct cJSON_Rendered {char *buf;size_t off,len;int placed,current;};
+/* item has left the place its parent's text gave it, so that slice is no longer its text. */
+static void unplace(cJSON *item)	{if (item->rendered) item->rendered->placed=0;}
+
+/* Set in the shared count of a chain's head while the chain names no parent though it still has an owner. */
+#define UNOWNED (1<<30)
+/* owner lets go of a chain someone else still has: if the chain names owner as its parent, it is left with none. */
+static void disown(cJSON *chain,cJSON *owner)	{if (chain && chain->parent==owner) {chain->shared|=UNOWNED;for (;chain;chain=chain->next) chain->parent=0,unplace(chain);}}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
 	cJSON *next;
+	if (c && (c->shared&~UNOWNED)) {c->shared--;return;}	/* Someone else still owns this chain. */
 	while (c)
 	{
 		next=c->next;
-		if (!(c->type&cJSON_IsReference) && c->child) cJSON_Delete(c->child);
-		if (!(c->type&cJSON_IsReference) && c->valuestring) cJSON_free(c->valuestring);
+		if (!(c->type&cJSON_IsReference) && c->child) {if (c->child->shared&~UNOWNED) disown(c->child,c);cJSON_Delete(c->child);}
+		if (!(c->type&cJSON_IsReference) && c->valuestring) cJSON_free(c->valuestring);	/* a string, or a packed array's numbers */
+		if (c->rendered) {if (c->rendered->buf) cJSON_free(c->rendered->buf);cJSON_free(c->rendered);}
 		if (c->string) cJSON_free(c->string);
 		cJSON_free(c);
 		c=next;
@@ -96,6 +199,7 @@ void cJSON_Delete(cJSON *c)
 static const char *parse_number(cJSON *item,const char *num)
 {
 	double n=0,sign=1,scale=0;int subscale=0,signsubscale=1;
+	STAT(double t0=stats_now());
 
 	if (*num=='-') sign=-1,num++;	/* Has sign? */
 	if (*num=='0') num++;			/* is zero */
@@ -111,29 +215,26 @@ static const char *parse_number(cJSON *item,const char *num)
 	item->valuedouble=n;
 	item->valueint=(int)n;
 	item->type=cJSON_Number;
+	STAT(stats.number_time+=stats_now()-t0);
 	return num;
 }
 
+/* Render the number nicely into str, which has room for 64 chars. i is d as an int, where that fits. */
+static int is_int(double d,int i)	{return fabs(((double)i)-d)<=DBL_EPSILON && d<=INT_MAX && d>=INT_MIN;}
+static void format_number(char *str,double d,int i)
+{
+	if (is_int(d,i))										sprintf(str,"%d",i);
+	else if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)sprintf(str,"%.0f",d);
+	else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)				sprintf(str,"%e",d);
+	else													sprintf(str,"%f",d);
+}
 /* Render the number nicely from the given item into a string. */
 static char *print_number(cJSON *item)
 {
 	char *str;
-	double d=item->valuedouble;
-	if (fabs(((double)item->valueint)-d)<=DBL_EPSILON && d<=INT_MAX && d>=INT_MIN)
-	{
-		str=(char*)cJSON_malloc(21);	/* 2^64+1 can be represented in 21 chars. */
-		if (str) sprintf(str,"%d",item->valueint);
-	}
-	else
-	{
-		str=(char*)cJSON_malloc(64);	/* This is a nice tradeoff. */
-		if (str)
-		{
-			if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)sprintf(str,"%.0f",d);
-			else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)			sprintf(str,"%e",d);
-			else												sprintf(str,"%f",d);
-		}
-	}
+	if (is_int(item->valuedouble,item->valueint))	str=(char*)cJSON_malloc(21);	/* 2^64+1 can be represented in 21 chars. */
+	else											str=(char*)cJSON_malloc(64);	/* This is a nice tradeoff. */
+	if (str) format_number(str,item->valuedouble,item->valueint);
 	return str;
 }
 
@@ -150,11 +251,27 @@ static unsigned parse_hex4(const char *str)
 	return h;
 }
 
-/* Parse the input text into an unescaped cstring, and populate item. */
+/* Write code point uc to out as UTF-8 and say how many bytes that took. With out 0, only say how many it would take. */
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
+static int utf8_encode(char *out,unsigned uc)
+{
+	int len=4;if (uc<0x80) len=1;else if (uc<0x800) len=2;else if (uc<0x10000) len=3;
+	if (!out) return len;
+	out+=len;
+	switch (len) {
+		case 4: *--out =((uc | 0x80) & 0xBF); uc >>= 6;
+		case 3: *--out =((uc | 0x80) & 0xBF); uc >>= 6;
+		case 2: *--out =((uc | 0x80) & 0xBF); uc >>= 6;
+		case 1: *--out =(uc | firstByteMark[len]);
+	}
+	return len;
+}
+
+/* Parse the input text into an unescaped cstring, and populate item. */
 static const char *parse_string(cJSON *item,const char *str)
 {
 	const char *ptr=str+1;char *ptr2;char *out;int len=0;unsigned uc,uc2;
+	STAT(double t0=stats_now());
 	if (*str!='\"') {ep=str;return 0;}	/* not a string! */
 	
 	while (*ptr!='\"' && *ptr && ++len) if (*ptr++ == '\\') ptr++;	/* Skip escaped quotes. */
@@ -189,15 +306,7 @@ static const char *parse_string(cJSON *item,const char *str)
 						uc=0x10000 + (((uc&0x3FF)<<10) | (uc2&0x3FF));
 					}
 
-					len=4;if (uc<0x80) len=1;else if (uc<0x800) len=2;else if (uc<0x10000) len=3; ptr2+=len;
-					
-					switch (len) {
-						case 4: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
-						case 3: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
-						case 2: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
-						case 1: *--ptr2 =(uc | firstByteMark[len]);
-					}
-					ptr2+=len;
+					ptr2+=utf8_encode(ptr2,uc);
 					break;
 				default:  *ptr2++=*ptr; break;
 			}
@@ -208,83 +317,190 @@ static const char *parse_string(cJSON *item,const char *str)
 	if (*ptr=='\"') ptr++;
 	item->valuestring=out;
 	item->type=cJSON_String;
+	STAT(stats.string_bytes+=ptr2-out;stats.string_time+=stats_now()-t0);
 	return ptr;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static char *print_string_ptr(const char *str)
+/* String escaping. escapes[] gives the letter that follows the backslash for each byte that needs one ('u' for \u00XX), or 0. */
+static const unsigned char escapes[256]={
+	'u','u','u','u','u','u','u','u','b','t','n','u','f','r','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u',
+	0,0,'\"',0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,'\\',0,0,0};
+static const char hex_digits[16]={'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+
+/* How many bytes from the start of str need no escaping. With ascii, bytes from 0x80 up count as needing it. */
+static size_t clean_run(const unsigned char *str,size_t len,int ascii)
 {
-	const char *ptr;char *ptr2,*out;int len=0;unsigned char token;
-	
-	if (!str) return cJSON_strdup("");
-	ptr=str;while ((token=*ptr) && ++len) {if (strchr("\"\\\b\f\n\r\t",token)) len++; else if (token<32) len+=5;ptr++;}
-	
-	out=(char*)cJSON_malloc(len+3);
-	if (!out) return 0;
+	size_t i=0;
+#if defined(__AVX2__)
+	const __m256i quote=_mm256_set1_epi8('\"'),backslash=_mm256_set1_epi8('\\'),space=_mm256_set1_epi8(31);
+	for (;i+32<=len;i+=32)
+	{
+		__m256i chunk=_mm256_loadu_si256((const __m256i*)(str+i));
+		__m256i special=_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk,quote),_mm256_cmpeq_epi8(chunk,backslash)),_mm256_cmpeq_epi8(_mm256_max_epu8(chunk,space),space));
+		unsigned mask=(unsigned)_mm256_movemask_epi8(special)|(ascii?(unsigned)_mm256_movemask_epi8(chunk):0);
+		if (mask) return i+__builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i quote=_mm_set1_epi8('\"'),backslash=_mm_set1_epi8('\\'),space=_mm_set1_epi8(31);
+	for (;i+16<=len;i+=16)
+	{
+		__m128i chunk=_mm_loadu_si128((const __m128i*)(str+i));
+		__m128i special=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk,quote),_mm_cmpeq_epi8(chunk,backslash)),_mm_cmpeq_epi8(_mm_max_epu8(chunk,space),space));
+		unsigned mask=(unsigned)_mm_movemask_epi8(special)|(ascii?(unsigned)_mm_movemask_epi8(chunk):0);
+		if (mask) return i+__builtin_ctz(mask);
+	}
+#endif
+	for (;i<len;i++) if (escapes[str[i]] || (ascii && str[i]>=0x80)) break;
+	return i;
+}
 
-	ptr2=out;ptr=str;
-	*ptr2++='\"';
-	while (*ptr)
+/* Decode the UTF-8 sequence at str into *code. Malformed bytes are taken one at a time, each as U+FFFD. */
+static size_t decode_utf8(const unsigned char *str,size_t len,unsigned *code)
+{
+	size_t n=0,i;unsigned c=str[0];
+	if (c>=0xF0 && c<0xF5)		n=4,c&=0x07;
+	else if (c>=0xE0 && c<0xF0)	n=3,c&=0x0F;
+	else if (c>=0xC2 && c<0xE0)	n=2,c&=0x1F;
+	if (n && n<=len)
+	{
+		for (i=1;i<n && (str[i]&0xC0)==0x80;i++) c=(c<<6)|(str[i]&0x3F);
+		if (i==n && c<=0x10FFFF && !(c>=0xD800 && c<=0xDFFF) && c>=(n==2?0x80u:n==3?0x800u:0x10000u)) {*code=c;return n;}
+	}
+	*code=0xFFFD;	/* the replacement character */
+	return 1;
+}
+
+/* Write \uXXXX for a code point below 0x10000. */
+static char *write_u(char *out,unsigned code)
+{
+	*out++='\\';*out++='u';
+	*out++=hex_digits[(code>>12)&15];*out++=hex_digits[(code>>8)&15];*out++=hex_digits[(code>>4)&15];*out++=hex_digits[code&15];
+	return out;
+}
+
+/* How long len bytes of in are once escaped, quotes not included. */
+static size_t escaped_size(const unsigned char *in,size_t len,int ascii)
+{
+	size_t i,run,outlen;unsigned code;
+	for (i=0,outlen=len;i<len;)
 	{
-		if ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\') *ptr2++=*ptr++;
+		i+=clean_run(in+i,len-i,ascii);
+		if (i==len) break;
+		if (escapes[in[i]])	{outlen+=(escapes[in[i]]=='u')?5:1;i++;}
+		else				{run=decode_utf8(in+i,len-i,&code);outlen+=((code>=0x10000)?12:6)-run;i+=run;}
+	}
+	return outlen;
+}
+/* Write len bytes of in escaped to out, which has room for escaped_size of them. Clean runs are found a vector at a time and copied whole. */
+static char *escape_into(char *ptr2,const unsigned char *in,size_t len,int ascii)
+{
+	size_t i,run;unsigned code;
+	for (i=0;i<len;)
+	{
+		run=clean_run(in+i,len-i,ascii);
+		memcpy(ptr2,in+i,run);ptr2+=run;i+=run;
+		if (i==len) break;
+		if (escapes[in[i]]=='u')	{ptr2=write_u(ptr2,in[i]);i++;}
+		else if (escapes[in[i]])	{*ptr2++='\\';*ptr2++=escapes[in[i]];i++;}
 		else
 		{
-			*ptr2++='\\';
-			switch (token=*ptr++)
-			{
-				case '\\':	*ptr2++='\\';	break;
-				case '\"':	*ptr2++='\"';	break;
-				case '\b':	*ptr2++='b';	break;
-				case '\f':	*ptr2++='f';	break;
-				case '\n':	*ptr2++='n';	break;
-				case '\r':	*ptr2++='r';	break;
-				case '\t':	*ptr2++='t';	break;
-				default: sprintf(ptr2,"u%04x",token);ptr2+=5;	break;	/* escape and print */
-			}
+			i+=decode_utf8(in+i,len-i,&code);
+			if (code<0x10000) ptr2=write_u(ptr2,code);
+			else {code-=0x10000;ptr2=write_u(ptr2,0xD800|(code>>10));ptr2=write_u(ptr2,0xDC00|(code&0x3FF));}	/* UTF16 surrogate pair. */
 		}
 	}
+	return ptr2;
+}
+/* Render the cstring provided to an escaped version that can be printed. */
+static char *print_string_ptr(const char *str,int opts)
+{
+	const unsigned char *in=(const unsigned char*)str;char *ptr2,*out;size_t len;
+	int ascii=opts&cJSON_PrintASCII;
+	
+	if (!str) return cJSON_strdup("");
+	len=strlen(str);
+	out=(char*)cJSON_malloc(escaped_size(in,len,ascii)+3);
+	if (!out) return 0;
+	ptr2=out;
+	*ptr2++='\"';
+	ptr2=escape_into(ptr2,in,len,ascii);
 	*ptr2++='\"';*ptr2++=0;
 	return out;
 }
 /* Invote print_string_ptr (which is useful) on an item. */
-static char *print_string(cJSON *item)	{return print_string_ptr(item->valuestring);}
+static char *print_string(cJSON *item,int opts)	{return print_string_ptr(item->valuestring,opts);}
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item,const char *value);
-static char *print_value(cJSON *item,int depth,int fmt);
-static const char *parse_array(cJSON *item,const char *value);
-static char *print_array(cJSON *item,int depth,int fmt);
-static const char *parse_object(cJSON *item,const char *value);
-static char *print_object(cJSON *item,int depth,int fmt);
+static const char *parse_value(cJSON *item,const char *value,int flags);
+static char *print_value(cJSON *item,int depth,int opts);
+static int print_caches(cJSON *item,int opts);
+static const char *rendered_at(cJSON *item);
+static void settle_child(cJSON *child,int keep,size_t off,const char *text,size_t len);
+static const char *parse_array(cJSON *item,const char *value,int flags);
+static char *print_array(cJSON *item,int depth,int opts);
+static const char *parse_object(cJSON *item,const char *value,int flags);
+static char *print_object(cJSON *item,int depth,int opts);
 
 /* Utility to jump whitespace and cr/lf */
 static const char *skip(const char *in) {while (in && *in && (unsigned char)*in<=32) in++; return in;}
 
 /* Parse an object - create a new root, and populate. */
-cJSON *cJSON_ParseWithOpts(const char *value,const char **return_parse_end,int require_null_terminated)
+cJSON *cJSON_ParseWithFlags(const char *value,const char **return_parse_end,int flags)
 {
 	const char *end=0;
-	cJSON *c=cJSON_New_Item();
+	cJSON *c;
+	STAT(double t0=stats_now();stats_depth=0);
+	c=cJSON_New_Item();
 	ep=0;
 	if (!c) return 0;       /* memory fail */
 
-	end=parse_value(c,skip(value));
+	end=parse_value(c,skip(value),flags);
+	STAT(stats.parse_time+=stats_now()-t0);
 	if (!end)	{cJSON_Delete(c);return 0;}	/* parse failure. ep is set. */
 
 	/* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-	if (require_null_terminated) {end=skip(end);if (*end) {cJSON_Delete(c);ep=end;return 0;}}
+	if (flags&cJSON_ParseRequireNullTerminated) {end=skip(end);if (*end) {cJSON_Delete(c);ep=end;return 0;}}
 	if (return_parse_end) *return_parse_end=end;
 	return c;
 }
+cJSON *cJSON_ParseWithOpts(const char *value,const char **return_parse_end,int require_null_terminated)	{return cJSON_ParseWithFlags(value,return_parse_end,require_null_terminated?cJSON_ParseRequireNullTerminated:0);}
 /* Default options for cJSON_Parse */
 cJSON *cJSON_Parse(const char *value) {return cJSON_ParseWithOpts(value,0,0);}
 
 /* Render a cJSON item/entity/structure to text. */
-char *cJSON_Print(cJSON *item)				{return print_value(item,0,1);}
-char *cJSON_PrintUnformatted(cJSON *item)	{return print_value(item,0,0);}
+#ifdef CJSON_STATS
+static char *print_timed(cJSON *item,int opts)	{double t0=stats_now();char *out=print_value(item,0,opts);stats.print_time+=stats_now()-t0;return out;}
+#else
+#define print_timed(item,opts) print_value(item,0,opts)
+#endif
+char *cJSON_PrintWithOpts(cJSON *item,int opts)
+{
+	char *out=print_timed(item,opts);
+	/* Kept text that no parent's text holds needs a copy of its own. */
+	if (out && print_caches(item,opts) && item->rendered && item->rendered->current && !rendered_at(item)) settle_child(item,0,0,out,strlen(out));
+	return out;
+}
+char *cJSON_Print(cJSON *item)				{return cJSON_PrintWithOpts(item,cJSON_PrintFormatted);}
+char *cJSON_PrintUnformatted(cJSON *item)	{return cJSON_PrintWithOpts(item,0);}
 
+#ifdef CJSON_STATS
+/* Count the item once it is parsed, and track how deep the containers go. */
+static const char *parse_value_core(cJSON *item,const char *value,int flags);
+static const char *parse_value(cJSON *item,const char *value,int flags)
+{
+	int nest=value && (*value=='[' || *value=='{');
+	if (nest && ++stats_depth>stats.max_depth) stats.max_depth=stats_depth;
+	value=parse_value_core(item,value,flags);
+	if (nest) stats_depth--;
+	if (value) stats.nodes[item->type&255]++;
+	return value;
+}
+#else
+#define parse_value_core parse_value
+#endif
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item,const char *value)
+static const char *parse_value_core(cJSON *item,const char *value,int flags)
 {
 	if (!value)						return 0;	/* Fail on null. */
 	if (!strncmp(value,"null",4))	{ item->type=cJSON_NULL;  return value+4; }
@@ -292,66 +508,179 @@ static const char *parse_value(cJSON *item,const char *value)
 	if (!strncmp(value,"true",4))	{ item->type=cJSON_True; item->valueint=1;	return value+4; }
 	if (*value=='\"')				{ return parse_string(item,value); }
 	if (*value=='-' || (*value>='0' && *value<='9'))	{ return parse_number(item,value); }
-	if (*value=='[')				{ return parse_array(item,value); }
-	if (*value=='{')				{ return parse_object(item,value); }
+	if (*value=='[')				{ return parse_array(item,value,flags); }
+	if (*value=='{')				{ return parse_object(item,value,flags); }
 
 	ep=value;return 0;	/* failure. */
 }
 
+/* Does this print keep and reuse item's text? */
+static int print_caches(cJSON *item,int opts)
+{
+	return (opts&(cJSON_PrintCached|cJSON_PrintFormatted|cJSON_PrintASCII))==cJSON_PrintCached && ((item->type&255)==cJSON_Array || (item->type&255)==cJSON_Object);
+}
+/* Where item's kept text is, or 0 if it has none: its own buffer, or the slice of its parent's. The text of an array/object
+that has been changed since stays where it was until it is printed again, as the text of children it holds may be current. */
+static const char *rendered_at(cJSON *item)
+{
+	struct cJSON_Rendered *r=item->rendered;const char *at;
+	if (!r) return 0;
+	if (r->buf) return r->buf;
+	if (!r->placed || !item->parent || !(at=rendered_at(item->parent))) return 0;
+	return at+r->off;
+}
+/* Can an array/object's text be kept once printed? Not if a reference lies anywhere below, as its text may change behind
+our back, nor if a child does not name it as its parent, as a change there would not reach it (see cJSON_MarkDirty).
+Children that could keep theirs already have, so only they need looking at. */
+static int cacheable(cJSON *item)
+{
+	cJSON *c;
+	if (item->type&cJSON_IsReference) return 0;
+	for (c=item->child;c;c=c->next)
+		if ((c->type&cJSON_IsReference) || c->parent!=item || (((c->type&255)==cJSON_Array || (c->type&255)==cJSON_Object) && !(c->rendered && c->rendered->current))) return 0;
+	return 1;
+}
+/* A child's text has just gone in at off in its parent's. If the parent keeps its text, the child's is now that slice;
+otherwise a child that keeps its text needs a copy of its own. */
+static void settle_child(cJSON *child,int keep,size_t off,const char *text,size_t len)
+{
+	struct cJSON_Rendered *r=child->rendered;
+	if (!r) return;
+	if (!keep && r->current && !r->buf && !(r->buf=cJSON_strdup(text))) r->current=0;
+	if (keep || !r->current) {if (r->buf) cJSON_free(r->buf);r->buf=0;}
+	r->off=off;r->len=len;r->placed=keep;
+}
+/* An array/object has just been printed; its old text, wherever that was, is gone. keep says whether its new text is
+kept: its parent then places it, or cJSON_PrintWithOpts gives it a buffer if it is the top. */
+static int settle(cJSON *item,int keep)
+{
+	if (keep && !item->rendered && (item->rendered=(struct cJSON_Rendered*)cJSON_malloc(sizeof(struct cJSON_Rendered)))) memset(item->rendered,0,sizeof(struct cJSON_Rendered));
+	if (!item->rendered) return 0;
+	if (item->rendered->buf) cJSON_free(item->rendered->buf);
+	item->rendered->buf=0;item->rendered->placed=0;item->rendered->current=keep;
+	return keep;
+}
+
 /* Render a value to text. */
-static char *print_value(cJSON *item,int depth,int fmt)
+static char *print_value(cJSON *item,int depth,int opts)
 {
-	char *out=0;
+	char *out=0;const char *at;
 	if (!item) return 0;
+	if (print_caches(item,opts) && item->rendered && item->rendered->current && (at=rendered_at(item)))
+	{
+		if ((out=(char*)cJSON_malloc(item->rendered->len+1))) {memcpy(out,at,item->rendered->len);out[item->rendered->len]=0;}
+		return out;
+	}
 	switch ((item->type)&255)
 	{
 		case cJSON_NULL:	out=cJSON_strdup("null");	break;
 		case cJSON_False:	out=cJSON_strdup("false");break;
 		case cJSON_True:	out=cJSON_strdup("true"); break;
 		case cJSON_Number:	out=print_number(item);break;
-		case cJSON_String:	out=print_string(item);break;
-		case cJSON_Array:	out=print_array(item,depth,fmt);break;
-		case cJSON_Object:	out=print_object(item,depth,fmt);break;
+		case cJSON_String:	out=print_string(item,opts);break;
+		case cJSON_Array:	out=print_array(item,depth,opts);break;
+		case cJSON_Object:	out=print_object(item,depth,opts);break;
 	}
 	return out;
 }
 
+/* A packed array has no string, so its block of numbers is kept at valuestring. */
+#define packed_numbers(item)	((double*)(item)->valuestring)
+
+/* Build a packed array from input text. If a value turns out not to be a number, the numbers before it become items,
+*tail is left at the last of them and the value is returned, for parse_array to carry on from. */
+static const char *parse_packed(cJSON *item,const char *value,cJSON **tail)
+{
+	double *numbers=0,*grown;int count=0,size=0,i;cJSON num,*n;
+	while (*value=='-' || (*value>='0' && *value<='9'))
+	{
+		if (count==size)
+		{
+			size=size?size*2:16;
+			if (!(grown=(double*)cJSON_malloc(size*sizeof(double)))) {cJSON_free(numbers);return 0;}	/* memory fail */
+			if (numbers) {memcpy(grown,numbers,count*sizeof(double));cJSON_free(numbers);}
+			numbers=grown;
+		}
+		value=skip(parse_number(&num,value));
+		numbers[count++]=num.valuedouble;
+		if (*value==']') {item->type|=cJSON_IsPacked;item->valuestring=(char*)numbers;item->valueint=count;STAT(stats.nodes[cJSON_Number]+=count);return value+1;}
+		if (*value!=',') {cJSON_free(numbers);ep=value;return 0;}	/* malformed. */
+		value=skip(value+1);
+	}
+	for (i=0;i<count;i++)
+	{
+		if (!(n=cJSON_CreateNumber(numbers[i]))) break;
+		if (*tail) (*tail)->next=n,n->prev=*tail; else item->child=n;
+		n->parent=item;*tail=n;
+	}
+	cJSON_free(numbers);
+	STAT(stats.nodes[cJSON_Number]+=i);
+	return (i==count)?value:0;
+}
+
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value)
+static const char *parse_array(cJSON *item,const char *value,int flags)
 {
-	cJSON *child;
+	cJSON *child=0,*new_item;
 	if (*value!='[')	{ep=value;return 0;}	/* not an array! */
 
 	item->type=cJSON_Array;
 	value=skip(value+1);
 	if (*value==']') return value+1;	/* empty array. */
+	if ((flags&cJSON_ParsePackNumbers) && (*value=='-' || (*value>='0' && *value<='9')))
+	{
+		if (!(value=parse_packed(item,value,&child))) return 0;
+		if (item->type&cJSON_IsPacked) return value;	/* Otherwise child is the last number so far, and the rest follow it. */
+	}
 
-	item->child=child=cJSON_New_Item();
-	if (!item->child) return 0;		 /* memory fail */
-	value=skip(parse_value(child,skip(value)));	/* skip any spacing, get the value. */
-	if (!value) return 0;
-
-	while (*value==',')
+	for (;;value=skip(value+1))
 	{
-		cJSON *new_item;
-		if (!(new_item=cJSON_New_Item())) return 0; 	/* memory fail */
-		child->next=new_item;new_item->prev=child;child=new_item;
-		value=skip(parse_value(child,skip(value+1)));
-		if (!value) return 0;	/* memory fail */
+		if (!(new_item=cJSON_New_Item())) return 0;	/* memory fail */
+		if (child) child->next=new_item,new_item->prev=child; else item->child=new_item;
+		new_item->parent=item;child=new_item;
+		value=skip(parse_value(child,skip(value),flags));	/* skip any spacing, get the value. */
+		if (!value) return 0;
+		if (*value!=',') break;
 	}
 
 	if (*value==']') return value+1;	/* end of array */
 	ep=value;return 0;	/* malformed. */
 }
 
+/* Render a packed array straight from its numbers. */
+static char *print_packed(cJSON *item,int fmt)
+{
+	char *out,*grown,num[64];size_t len=1,size,n;int i;double d;
+	size=item->valueint*16+3;
+	if (!(out=(char*)cJSON_malloc(size))) return 0;
+	*out='[';
+	for (i=0;i<item->valueint;i++)
+	{
+		d=packed_numbers(item)[i];
+		format_number(num,d,(d<=INT_MAX && d>=INT_MIN)?(int)d:0);
+		n=strlen(num);
+		if (len+n+4>size)
+		{
+			size=size*2+n;
+			if (!(grown=(char*)cJSON_malloc(size))) {cJSON_free(out);return 0;}
+			memcpy(grown,out,len);cJSON_free(out);out=grown;
+		}
+		if (i) {out[len++]=',';if (fmt) out[len++]=' ';}
+		memcpy(out+len,num,n);len+=n;
+	}
+	out[len++]=']';out[len]=0;
+	return out;
+}
+
 /* Render an array to text */
-static char *print_array(cJSON *item,int depth,int fmt)
+static char *print_array(cJSON *item,int depth,int opts)
 {
 	char **entries;
 	char *out=0,*ptr,*ret;int len=5;
 	cJSON *child=item->child;
-	int numentries=0,i=0,fail=0;
+	int numentries=0,i=0,fail=0,fmt=opts&cJSON_PrintFormatted,cache=print_caches(item,opts),keep;
 	
+	if (item->type&cJSON_IsPacked) {out=print_packed(item,fmt);if (out && cache) settle(item,cacheable(item));return out;}
 	/* How many entries in the array? */
 	while (child) numentries++,child=child->next;
 	/* Explicitly handle numentries==0 */
@@ -359,6 +688,7 @@ static char *print_array(cJSON *item,int depth,int fmt)
 	{
 		out=(char*)cJSON_malloc(3);
 		if (out) strcpy(out,"[]");
+		if (out && cache) settle(item,cacheable(item));
 		return out;
 	}
 	/* Allocate an array to hold the values for each */
@@ -369,7 +699,7 @@ static char *print_array(cJSON *item,int depth,int fmt)
 	child=item->child;
 	while (child && !fail)
 	{
-		ret=print_value(child,depth+1,fmt);
+		ret=print_value(child,depth+1,opts);
 		entries[i++]=ret;
 		if (ret) len+=strlen(ret)+2+(fmt?1:0); else fail=1;
 		child=child->next;
@@ -389,11 +719,14 @@ static char *print_array(cJSON *item,int depth,int fmt)
 	}
 	
 	/* Compose the output array. */
+	keep=cache && settle(item,cacheable(item));
 	*out='[';
 	ptr=out+1;*ptr=0;
-	for (i=0;i<numentries;i++)
+	for (i=0,child=item->child;i<numentries;i++,child=child->next)
 	{
-		strcpy(ptr,entries[i]);ptr+=strlen(entries[i]);
+		len=strlen(entries[i]);
+		if (cache) settle_child(child,keep,ptr-out,entries[i],len);
+		strcpy(ptr,entries[i]);ptr+=len;
 		if (i!=numentries-1) {*ptr++=',';if(fmt)*ptr++=' ';*ptr=0;}
 		cJSON_free(entries[i]);
 	}
@@ -403,7 +736,7 @@ static char *print_array(cJSON *item,int depth,int fmt)
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item,const char *value)
+static const char *parse_object(cJSON *item,const char *value,int flags)
 {
 	cJSON *child;
 	if (*value!='{')	{ep=value;return 0;}	/* not an object! */
@@ -414,23 +747,24 @@ static const char *parse_object(cJSON *item,const char *value)
 	
 	item->child=child=cJSON_New_Item();
 	if (!item->child) return 0;
+	child->parent=item;
 	value=skip(parse_string(child,skip(value)));
 	if (!value) return 0;
 	child->string=child->valuestring;child->valuestring=0;
 	if (*value!=':') {ep=value;return 0;}	/* fail! */
-	value=skip(parse_value(child,skip(value+1)));	/* skip any spacing, get the value. */
+	value=skip(parse_value(child,skip(value+1),flags));	/* skip any spacing, get the value. */
 	if (!value) return 0;
 	
 	while (*value==',')
 	{
 		cJSON *new_item;
 		if (!(new_item=cJSON_New_Item()))	return 0; /* memory fail */
-		child->next=new_item;new_item->prev=child;child=new_item;
+		child->next=new_item;new_item->prev=child;new_item->parent=item;child=new_item;
 		value=skip(parse_string(child,skip(value+1)));
 		if (!value) return 0;
 		child->string=child->valuestring;child->valuestring=0;
 		if (*value!=':') {ep=value;return 0;}	/* fail! */
-		value=skip(parse_value(child,skip(value+1)));	/* skip any spacing, get the value. */
+		value=skip(parse_value(child,skip(value+1),flags));	/* skip any spacing, get the value. */
 		if (!value) return 0;
 	}
 	
@@ -439,10 +773,10 @@ static const char *parse_object(cJSON *item,const char *value)
 }
 
 /* Render an object to text. */
-static char *print_object(cJSON *item,int depth,int fmt)
+static char *print_object(cJSON *item,int depth,int opts)
 {
 	char **entries=0,**names=0;
-	char *out=0,*ptr,*ret,*str;int len=7,i=0,j;
+	char *out=0,*ptr,*ret,*str;int len=7,i=0,j,fmt=opts&cJSON_PrintFormatted,cache=print_caches(item,opts),keep;
 	cJSON *child=item->child;
 	int numentries=0,fail=0;
 	/* Count the number of entries. */
@@ -455,6 +789,7 @@ static char *print_object(cJSON *item,int depth,int fmt)
 		ptr=out;*ptr++='{';
 		if (fmt) {*ptr++='\n';for (i=0;i<depth-1;i++) *ptr++='\t';}
 		*ptr++='}';*ptr++=0;
+		if (cache) settle(item,cacheable(item));
 		return out;
 	}
 	/* Allocate space for the names and the objects */
@@ -469,8 +804,8 @@ static char *print_object(cJSON *item,int depth,int fmt)
 	child=item->child;depth++;if (fmt) len+=depth;
 	while (child)
 	{
-		names[i]=str=print_string_ptr(child->string);
-		entries[i++]=ret=print_value(child,depth,fmt);
+		names[i]=str=print_string_ptr(child->string,opts);
+		entries[i++]=ret=print_value(child,depth,opts);
 		if (str && ret) len+=strlen(ret)+strlen(str)+2+(fmt?2+depth:0); else fail=1;
 		child=child->next;
 	}
@@ -488,13 +823,16 @@ static char *print_object(cJSON *item,int depth,int fmt)
 	}
 	
 	/* Compose the output: */
+	keep=cache && settle(item,cacheable(item));
 	*out='{';ptr=out+1;if (fmt)*ptr++='\n';*ptr=0;
-	for (i=0;i<numentries;i++)
+	for (i=0,child=item->child;i<numentries;i++,child=child->next)
 	{
 		if (fmt) for (j=0;j<depth;j++) *ptr++='\t';
 		strcpy(ptr,names[i]);ptr+=strlen(names[i]);
 		*ptr++=':';if (fmt) *ptr++='\t';
-		strcpy(ptr,entries[i]);ptr+=strlen(entries[i]);
+		len=strlen(entries[i]);
+		if (cache) settle_child(child,keep,ptr-out,entries[i],len);
+		strcpy(ptr,entries[i]);ptr+=len;
 		if (i!=numentries-1) *ptr++=',';
 		if (fmt) *ptr++='\n';*ptr=0;
 		cJSON_free(names[i]);cJSON_free(entries[i]);
@@ -506,33 +844,115 @@ static char *print_object(cJSON *item,int depth,int fmt)
 	return out;	
 }
 
-/* Get Array size/item / object item. */
-int    cJSON_GetArraySize(cJSON *array)							{cJSON *c=array->child;int i=0;while(c)i++,c=c->next;return i;}
-cJSON *cJSON_GetArrayItem(cJSON *array,int item)				{cJSON *c=array->child;  while (c && item>0) item--,c=c->next; return c;}
-cJSON *cJSON_GetObjectItem(cJSON *object,const char *string)	{cJSON *c=object->child; while (c && cJSON_strcasecmp(c->string,string)) c=c->next; return c;}
-
 /* Utility for array list handling. */
 static void suffix_object(cJSON *prev,cJSON *item) {prev->next=item;item->prev=prev;}
+/* Make item the parent of every item in its chain of children. */
+static cJSON *adopt(cJSON *item) {cJSON *c;if (item && item->child) item->child->shared&=~UNOWNED;if (item) for (c=item->child;c;c=c->next) {if (c->parent!=item) unplace(c);c->parent=item;}return item;}
 /* Utility for handling references. */
-static cJSON *create_reference(cJSON *item) {cJSON *ref=cJSON_New_Item();if (!ref) return 0;memcpy(ref,item,sizeof(cJSON));ref->string=0;ref->type|=cJSON_IsReference;ref->next=ref->prev=0;return ref;}
+static cJSON *create_reference(cJSON *item) {cJSON *ref=cJSON_New_Item();if (!ref) return 0;memcpy(ref,item,sizeof(cJSON));ref->string=0;ref->type|=cJSON_IsReference;ref->next=ref->prev=ref->parent=0;ref->shared=0;ref->hash=0;ref->rendered=0;return ref;}
+
+/* Give copy its own block of item's packed numbers. */
+static int copy_packed(cJSON *copy,cJSON *item)
+{
+	if (!(item->type&cJSON_IsPacked) || !item->valuestring) return 1;
+	if (!(copy->valuestring=(char*)cJSON_malloc(item->valueint*sizeof(double)))) return 0;
+	memcpy(copy->valuestring,item->valuestring,item->valueint*sizeof(double));
+	return 1;
+}
+/* Turn a packed array back into a chain of number items. A reference to one gets a chain of its own. */
+static int unpack(cJSON *item)
+{
+	cJSON *n,*head=0,*prev=0;int i;
+	if (!(item->type&cJSON_IsPacked)) return 1;
+	for (i=0;i<item->valueint;i++)
+	{
+		if (!(n=cJSON_CreateNumber(packed_numbers(item)[i]))) {cJSON_Delete(head);return 0;}
+		if (prev) suffix_object(prev,n); else head=n;
+		prev=n;
+	}
+	if (!(item->type&cJSON_IsReference)) cJSON_free(item->valuestring);
+	item->type&=~(cJSON_IsPacked|cJSON_IsReference);
+	item->valuestring=0;item->valueint=0;item->child=head;adopt(item);
+	return 1;
+}
+
+/* Utilities for shared chains. share_item copies a single item and shares its children; references stay references if keep_refs. */
+static cJSON *share_item(cJSON *item,int keep_refs)
+{
+	cJSON *copy=cJSON_New_Item();
+	int ref=keep_refs && (item->type&cJSON_IsReference);
+	if (!copy) return 0;
+	copy->type=ref?item->type:(item->type&(~cJSON_IsReference));copy->valueint=item->valueint;copy->valuedouble=item->valuedouble;
+	if (ref) copy->valuestring=item->valuestring; else if (!copy_packed(copy,item)) {cJSON_Delete(copy);return 0;}
+	if (item->valuestring && !copy->valuestring)	{copy->valuestring=cJSON_strdup(item->valuestring);	if (!copy->valuestring)	{cJSON_Delete(copy);return 0;}}
+	if (item->string)		{copy->string=cJSON_strdup(item->string);								if (!copy->string)		{cJSON_Delete(copy);return 0;}}
+	copy->child=item->child;
+	if (copy->child && !ref) copy->child->shared++;
+	copy->hash=item->hash;
+	return copy;
+}
+/* Give array/object a private copy of a shared chain of children. Returns 0 on memory fail, leaving it untouched. */
+static int unshare(cJSON *item)
+{
+	cJSON *c,*n,*head=0,*prev=0;
+	if (!item || (item->type&cJSON_IsReference) || !item->child || !(item->child->shared&~UNOWNED)) return 1;
+	for (c=item->child;c;c=c->next)
+	{
+		if (!(n=share_item(c,1))) {cJSON_Delete(head);return 0;}
+		if (prev) suffix_object(prev,n); else head=n;
+		prev=n;
+	}
+	item->child->shared--;disown(item->child,item);item->child=head;adopt(item);
+	return 1;
+}
+/* Forget the cached hash and text of item and of everything above it. */
+void cJSON_MarkDirty(cJSON *item)	{for (;item;item=item->parent) {item->hash=0;if (item->rendered) item->rendered->current=0;}}
+/* A change to item stays in the one tree unless some array/object above it shares its children with another, or the
+walk up through ->parent ends at a chain whose owner let go rather than at a top item (so the rest is not known). */
+int cJSON_IsShared(cJSON *item)
+{
+	if (!item) return 0;
+	for (;item->parent;item=item->parent) if (item->parent->child->shared) return 1;
+	while (item->prev) item=item->prev;
+	return item->shared!=0;
+}
+/* Called on an array/object about to be handed out or changed: refuse if it was reached through a shared chain,
+unpack it, make its children private and its own, and forget the cached hashes and text above it. */
+static int touch(cJSON *item)
+{
+	if (!item) return 1;
+	if (cJSON_IsShared(item) || !unpack(item) || !unshare(item)) return 0;
+	if (item->child && (item->child->parent!=item || item->child->shared) && !(item->type&cJSON_IsReference)) adopt(item);
+	cJSON_MarkDirty(item);
+	return 1;
+}
+
+/* Get Array size/item / object item. */
+int    cJSON_GetArraySize(cJSON *array)							{cJSON *c=array->child;int i=0;if (array->type&cJSON_IsPacked) return array->valueint;while(c)i++,c=c->next;return i;}
+cJSON *cJSON_GetArrayItem(cJSON *array,int item)				{cJSON *c=array->child;  while (c && item>0) item--,c=c->next; return c;}
+cJSON *cJSON_GetObjectItem(cJSON *object,const char *string)	{cJSON *c=object->child; while (c && cJSON_strcasecmp(c->string,string)) c=c->next; return c;}
+cJSON *cJSON_GetArrayItemForWrite(cJSON *array,int item)			{return touch(array)?cJSON_GetArrayItem(array,item):0;}
+cJSON *cJSON_GetObjectItemForWrite(cJSON *object,const char *string)	{return touch(object)?cJSON_GetObjectItem(object,string):0;}
 
 /* Add item to array/object. */
-void   cJSON_AddItemToArray(cJSON *array, cJSON *item)						{cJSON *c=array->child;if (!item) return; if (!c) {array->child=item;} else {while (c && c->next) c=c->next; suffix_object(c,item);}}
-void   cJSON_AddItemToObject(cJSON *object,const char *string,cJSON *item)	{if (!item) return; if (item->string) cJSON_free(item->string);item->string=cJSON_strdup(string);cJSON_AddItemToArray(object,item);}
-void	cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)						{cJSON_AddItemToArray(array,create_reference(item));}
-void	cJSON_AddItemReferenceToObject(cJSON *object,const char *string,cJSON *item)	{cJSON_AddItemToObject(object,string,create_reference(item));}
+int    cJSON_AddItemToArray(cJSON *array, cJSON *item)						{cJSON *c;if (!item || !touch(array)) return 0; item->parent=array;c=array->child; if (!c) {array->child=item;} else {while (c && c->next) c=c->next; suffix_object(c,item);}return 1;}
+int    cJSON_AddItemToObject(cJSON *object,const char *string,cJSON *item)	{if (!item) return 0; if (item->string) cJSON_free(item->string);item->string=cJSON_strdup(string);return item->string && cJSON_AddItemToArray(object,item);}
+int	cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)						{cJSON *ref=create_reference(item);if (cJSON_AddItemToArray(array,ref)) return 1;cJSON_Delete(ref);return 0;}
+int	cJSON_AddItemReferenceToObject(cJSON *object,const char *string,cJSON *item)	{cJSON *ref=create_reference(item);if (cJSON_AddItemToObject(object,string,ref)) return 1;cJSON_Delete(ref);return 0;}
 
-cJSON *cJSON_DetachItemFromArray(cJSON *array,int which)			{cJSON *c=array->child;while (c && which>0) c=c->next,which--;if (!c) return 0;
-	if (c->prev) c->prev->next=c->next;if (c->next) c->next->prev=c->prev;if (c==array->child) array->child=c->next;c->prev=c->next=0;return c;}
+cJSON *cJSON_DetachItemFromArray(cJSON *array,int which)			{cJSON *c;if (!touch(array)) return 0;c=array->child;while (c && which>0) c=c->next,which--;if (!c) return 0;
+	if (c->prev) c->prev->next=c->next;if (c->next) c->next->prev=c->prev;if (c==array->child) array->child=c->next;c->prev=c->next=c->parent=0;unplace(c);return c;}
 void   cJSON_DeleteItemFromArray(cJSON *array,int which)			{cJSON_Delete(cJSON_DetachItemFromArray(array,which));}
 cJSON *cJSON_DetachItemFromObject(cJSON *object,const char *string) {int i=0;cJSON *c=object->child;while (c && cJSON_strcasecmp(c->string,string)) i++,c=c->next;if (c) return cJSON_DetachItemFromArray(object,i);return 0;}
 void   cJSON_DeleteItemFromObject(cJSON *object,const char *string) {cJSON_Delete(cJSON_DetachItemFromObject(object,string));}
 
 /* Replace array/object items with new ones. */
-void   cJSON_ReplaceItemInArray(cJSON *array,int which,cJSON *newitem)		{cJSON *c=array->child;while (c && which>0) c=c->next,which--;if (!c) return;
-	newitem->next=c->next;newitem->prev=c->prev;if (newitem->next) newitem->next->prev=newitem;
-	if (c==array->child) array->child=newitem; else newitem->prev->next=newitem;c->next=c->prev=0;cJSON_Delete(c);}
-void   cJSON_ReplaceItemInObject(cJSON *object,const char *string,cJSON *newitem){int i=0;cJSON *c=object->child;while(c && cJSON_strcasecmp(c->string,string))i++,c=c->next;if(c){newitem->string=cJSON_strdup(string);cJSON_ReplaceItemInArray(object,i,newitem);}}
+int    cJSON_InsertItemInArray(cJSON *array,int which,cJSON *newitem)		{cJSON *c;if (!newitem || !touch(array)) return 0;c=array->child;while (c && which>0) c=c->next,which--;if (!c) return cJSON_AddItemToArray(array,newitem);
+	newitem->next=c;newitem->prev=c->prev;newitem->parent=array;c->prev=newitem;if (c==array->child) array->child=newitem; else newitem->prev->next=newitem;return 1;}
+int    cJSON_ReplaceItemInArray(cJSON *array,int which,cJSON *newitem)		{cJSON *c;if (!newitem || !touch(array)) return 0;c=array->child;while (c && which>0) c=c->next,which--;if (!c) return 0;
+	newitem->next=c->next;newitem->prev=c->prev;newitem->parent=array;if (newitem->next) newitem->next->prev=newitem;
+	if (c==array->child) array->child=newitem; else newitem->prev->next=newitem;c->next=c->prev=0;cJSON_Delete(c);return 1;}
+int    cJSON_ReplaceItemInObject(cJSON *object,const char *string,cJSON *newitem){int i=0;cJSON *c=object->child;while(c && cJSON_strcasecmp(c->string,string))i++,c=c->next;if(!c || !newitem) return 0;newitem->string=cJSON_strdup(string);return cJSON_ReplaceItemInArray(object,i,newitem);}
 
 /* Create basic types: */
 cJSON *cJSON_CreateNull(void)					{cJSON *item=cJSON_New_Item();if(item)item->type=cJSON_NULL;return item;}
@@ -545,10 +965,35 @@ cJSON *cJSON_CreateArray(void)					{cJSON *item=cJSON_New_Item();if(item)item->t
 cJSON *cJSON_CreateObject(void)					{cJSON *item=cJSON_New_Item();if(item)item->type=cJSON_Object;return item;}
 
 /* Create Arrays: */
-cJSON *cJSON_CreateIntArray(const int *numbers,int count)		{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
-cJSON *cJSON_CreateFloatArray(const float *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
-cJSON *cJSON_CreateDoubleArray(const double *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
-cJSON *cJSON_CreateStringArray(const char **strings,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateString(strings[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return a;}
+cJSON *cJSON_CreateIntArray(const int *numbers,int count)		{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return adopt(a);}
+cJSON *cJSON_CreateFloatArray(const float *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return adopt(a);}
+cJSON *cJSON_CreateDoubleArray(const double *numbers,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateNumber(numbers[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return adopt(a);}
+cJSON *cJSON_CreateStringArray(const char **strings,int count)	{int i;cJSON *n=0,*p=0,*a=cJSON_CreateArray();for(i=0;a && i<count;i++){n=cJSON_CreateString(strings[i]);if(!i)a->child=n;else suffix_object(p,n);p=n;}return adopt(a);}
+static cJSON *create_packed(int count)	{cJSON *a=cJSON_CreateArray();if (a && count>0) {if (!(a->valuestring=(char*)cJSON_malloc(count*sizeof(double)))) {cJSON_Delete(a);return 0;}a->type|=cJSON_IsPacked;a->valueint=count;}return a;}
+cJSON *cJSON_CreatePackedIntArray(const int *numbers,int count)		{int i;cJSON *a=create_packed(count);for(i=0;a && i<count;i++) packed_numbers(a)[i]=numbers[i];return a;}
+cJSON *cJSON_CreatePackedFloatArray(const float *numbers,int count)	{int i;cJSON *a=create_packed(count);for(i=0;a && i<count;i++) packed_numbers(a)[i]=numbers[i];return a;}
+cJSON *cJSON_CreatePackedDoubleArray(const double *numbers,int count)	{cJSON *a=create_packed(count);if (a && count>0) memcpy(packed_numbers(a),numbers,count*sizeof(double));return a;}
+
+/* Read number arrays: */
+double *cJSON_GetDoubleArrayData(cJSON *array)	{return (array && (array->type&cJSON_IsPacked))?packed_numbers(array):0;}
+int cJSON_GetDoubleArray(cJSON *array,double *numbers,int max)
+{
+	cJSON *c;int i=0;
+	if (!array || (array->type&255)!=cJSON_Array) return -1;
+	if (array->type&cJSON_IsPacked) {i=(array->valueint<max)?array->valueint:max;if (i>0) memcpy(numbers,packed_numbers(array),i*sizeof(double));return i;}
+	for (c=array->child;c;c=c->next) if ((c->type&255)!=cJSON_Number) return -1;
+	for (c=array->child;c && i<max;c=c->next) numbers[i++]=c->valuedouble;
+	return i;
+}
+int cJSON_GetIntArray(cJSON *array,int *numbers,int max)
+{
+	cJSON *c;int i=0;
+	if (!array || (array->type&255)!=cJSON_Array) return -1;
+	if (array->type&cJSON_IsPacked) {for (;i<array->valueint && i<max;i++) numbers[i]=(int)packed_numbers(array)[i];return i;}
+	for (c=array->child;c;c=c->next) if ((c->type&255)!=cJSON_Number) return -1;
+	for (c=array->child;c && i<max;c=c->next) numbers[i++]=c->valueint;
+	return i;
+}
 
 /* Duplication */
 cJSON *cJSON_Duplicate(cJSON *item,int recurse)
@@ -561,7 +1006,8 @@ cJSON *cJSON_Duplicate(cJSON *item,int recurse)
 	if (!newitem) return 0;
 	/* Copy over all vars */
 	newitem->type=item->type&(~cJSON_IsReference),newitem->valueint=item->valueint,newitem->valuedouble=item->valuedouble;
-	if (item->valuestring)	{newitem->valuestring=cJSON_strdup(item->valuestring);	if (!newitem->valuestring)	{cJSON_Delete(newitem);return 0;}}
+	if (!copy_packed(newitem,item))	{cJSON_Delete(newitem);return 0;}
+	if (item->valuestring && !newitem->valuestring)	{newitem->valuestring=cJSON_strdup(item->valuestring);	if (!newitem->valuestring)	{cJSON_Delete(newitem);return 0;}}
 	if (item->string)		{newitem->string=cJSON_strdup(item->string);			if (!newitem->string)		{cJSON_Delete(newitem);return 0;}}
 	/* If non-recursive, then we're done! */
 	if (!recurse) return newitem;
@@ -571,6 +1017,7 @@ cJSON *cJSON_Duplicate(cJSON *item,int recurse)
 	{
 		newchild=cJSON_Duplicate(cptr,1);		/* Duplicate (with recurse) each item in the ->next chain */
 		if (!newchild) {cJSON_Delete(newitem);return 0;}
+		newchild->parent=newitem;
 		if (nptr)	{nptr->next=newchild,newchild->prev=nptr;nptr=newchild;}	/* If newitem->child already set, then crosswire ->prev and ->next and move on */
 		else		{newitem->child=newchild;nptr=newchild;}					/* Set newitem->child and move to it */
 		cptr=cptr->next;
@@ -578,6 +1025,129 @@ cJSON *cJSON_Duplicate(cJSON *item,int recurse)
 	return newitem;
 }
 
+/* Constant-time duplication: share the children, see share_item/unshare above. */
+cJSON *cJSON_DuplicateShared(cJSON *item)	{return item?share_item(item,0):0;}
+
+/* Structural hashing: FNV-1a over the contents, with a finalizer to mix in the hashes of children. */
+static unsigned hash_bytes(unsigned h,const void *data,size_t len)	{const unsigned char *p=(const unsigned char*)data;while (len--) h=(h^*p++)*16777619u;return h;}
+static unsigned hash_string(unsigned h,const char *str)				{if (str) while (*str) h=(h^(unsigned char)*str++)*16777619u;return (h^0xff)*16777619u;}
+static unsigned hash_mix(unsigned h)								{h^=h>>16;h*=0x85ebca6bu;h^=h>>13;h*=0xc2b2ae35u;h^=h>>16;return h;}
+static unsigned hash_number(double d,int flags)
+{
+	unsigned h=2166136261u;int type=cJSON_Number;
+	if (!(flags&cJSON_HashExact) && d==0) d=0;	/* fold -0 into 0 */
+	h=hash_bytes(h,&type,sizeof(type));
+	return hash_bytes(h,&d,sizeof(d))>>3;
+}
+
+unsigned cJSON_Hash(cJSON *item,int flags)
+{
+	unsigned h=2166136261u,sum=0,member;cJSON *c;int type,i,own=1;
+	int mode=(flags&(cJSON_HashUnordered|cJSON_HashExact))|cJSON_HashCache;
+	if (!item) return 0;
+	if ((flags&cJSON_HashCache) && (item->hash&7)==(unsigned)mode) return item->hash>>3;
+
+	type=item->type&255;
+	if (type==cJSON_Number) return hash_number(item->valuedouble,flags);
+	h=hash_bytes(h,&type,sizeof(type));
+	switch (type)
+	{
+		case cJSON_String:	h=hash_string(h,item->valuestring);break;
+		case cJSON_Array:	if (item->type&cJSON_IsPacked) for (i=0;i<item->valueint;i++) h=hash_mix(h^hash_number(packed_numbers(item)[i],flags));	/* the same as unpacked */
+							for (c=item->child;c;c=c->next) h=hash_mix(h^cJSON_Hash(c,flags)),own&=c->parent==item;
+							break;
+		case cJSON_Object:
+			for (c=item->child;c;c=c->next)
+			{
+				member=hash_mix(hash_string(2166136261u,c->string)+cJSON_Hash(c,flags));own&=c->parent==item;
+				if (flags&cJSON_HashUnordered) sum+=member;	/* commutative, so member order does not matter */
+				else h=hash_mix(h^member);
+			}
+			if (flags&cJSON_HashUnordered) h=hash_mix(h^sum);
+			break;
+	}
+	h>>=3;	/* 29 bits, so a cached hash and its flags fit one word */
+	/* Kept only where a change below would reach it through ->parent (see cJSON_MarkDirty). */
+	if ((flags&cJSON_HashCache) && (type==cJSON_Array || type==cJSON_Object) && !(item->type&cJSON_IsReference) && own) item->hash=(h<<3)|mode;
+	return h;
+}
+
+/* Unordered object comparison: sort both member lists by name and value hash, then pair the runs up. */
+typedef struct {cJSON *item;unsigned hash;} hashed_member;
+static int compare_members(const void *a,const void *b)
+{
+	const hashed_member *x=(const hashed_member*)a,*y=(const hashed_member*)b;
+	int r=strcmp(x->item->string?x->item->string:"",y->item->string?y->item->string:"");
+	if (r) return r;
+	return (x->hash>y->hash)-(x->hash<y->hash);
+}
+static int equal_unordered(cJSON *a,cJSON *b,int flags)
+{
+	hashed_member local[32],*as,*bs;cJSON *c;int n=0,m=0,i,j,k,ok=1;
+	for (c=a->child;c;c=c->next) n++;
+	for (c=b->child;c;c=c->next) m++;
+	if (n!=m) return 0;
+	as=(n*2<=32)?local:(hashed_member*)cJSON_malloc(n*2*sizeof(hashed_member));
+	if (!as) return 0;
+	bs=as+n;
+	for (i=0,c=a->child;c;c=c->next,i++) as[i].item=c,as[i].hash=cJSON_Hash(c,flags);
+	for (i=0,c=b->child;c;c=c->next,i++) bs[i].item=c,bs[i].hash=cJSON_Hash(c,flags);
+	qsort(as,n,sizeof(hashed_member),compare_members);
+	qsort(bs,n,sizeof(hashed_member),compare_members);
+	for (i=0;ok && i<n;i=k)
+	{
+		/* [i,k) is a run of members with the same name and hash; b must have the same run, matched one to one. */
+		for (k=i+1;k<n && !compare_members(&as[i],&as[k]);k++);
+		for (j=i;ok && j<k;j++) ok=!compare_members(&as[i],&bs[j]);
+		if (ok && k<n) ok=compare_members(&as[i],&bs[k])!=0;
+		for (j=i;ok && j<k;j++)
+		{
+			int l;
+			for (l=i;l<k && !(bs[l].item && cJSON_Equal(as[j].item,bs[l].item,flags));l++);
+			if (l==k) ok=0; else bs[l].item=0;
+		}
+	}
+	if (as!=local) cJSON_free(as);
+	return ok;
+}
+
+static int number_equal(double x,double y,int flags)	{return (flags&cJSON_HashExact)?!memcmp(&x,&y,sizeof(double)):x==y;}
+/* Compare two arrays where at least one is packed. */
+static int equal_packed(cJSON *a,cJSON *b,int flags)
+{
+	cJSON *c,*t;int i;
+	if (!(a->type&cJSON_IsPacked)) t=a,a=b,b=t;
+	if (cJSON_GetArraySize(a)!=cJSON_GetArraySize(b)) return 0;
+	if (b->type&cJSON_IsPacked) {for (i=0;i<a->valueint;i++) if (!number_equal(packed_numbers(a)[i],packed_numbers(b)[i],flags)) return 0;return 1;}
+	for (i=0,c=b->child;c;c=c->next,i++) if ((c->type&255)!=cJSON_Number || !number_equal(packed_numbers(a)[i],c->valuedouble,flags)) return 0;
+	return 1;
+}
+
+int cJSON_Equal(cJSON *a,cJSON *b,int flags)
+{
+	cJSON *ca,*cb;
+	if (a==b) return 1;
+	if (!a || !b || (a->type&255)!=(b->type&255)) return 0;
+	switch (a->type&255)
+	{
+		case cJSON_Number:	return number_equal(a->valuedouble,b->valuedouble,flags);
+		case cJSON_String:	return !strcmp(a->valuestring?a->valuestring:"",b->valuestring?b->valuestring:"");
+		case cJSON_Array:
+		case cJSON_Object:
+			if ((a->type|b->type)&cJSON_IsPacked) return equal_packed(a,b,flags);
+			if (a->child==b->child) return 1;	/* the same (or a shared) chain */
+			if ((flags&cJSON_HashCache) && cJSON_Hash(a,flags)!=cJSON_Hash(b,flags)) return 0;
+			if ((a->type&255)==cJSON_Object && (flags&cJSON_HashUnordered)) return equal_unordered(a,b,flags);
+			for (ca=a->child,cb=b->child;ca && cb;ca=ca->next,cb=cb->next)
+			{
+				if ((a->type&255)==cJSON_Object && strcmp(ca->string?ca->string:"",cb->string?cb->string:"")) return 0;
+				if (!cJSON_Equal(ca,cb,flags)) return 0;
+			}
+			return !ca && !cb;
+	}
+	return 1;	/* null, true and false carry nothing beyond their type. */
+}
+
 void cJSON_Minify(char *json)
 {
 	char *into=json;
@@ -594,3 +1164,359 @@ void cJSON_Minify(char *json)
 	}
 	*into=0;	// and null-terminate.
 }
+
+/* Struct binding. A compiled schema keeps, beside the table, each member's name length and printed key, the nested
+schemas, and an open-addressed table indexed by hash_bytes(seed,name) whose seed is searched for until no two names collide. */
+struct cJSON_Schema {
+	const cJSON_Field *fields;int count;
+	size_t *namelen;char **keys;size_t *keylen;
+	cJSON_Schema **nested;
+	unsigned seed,mask;int *slots;
+};
+
+void cJSON_DeleteSchema(cJSON_Schema *s)
+{
+	int i;
+	if (!s) return;
+	for (i=0;i<s->count;i++) {if (s->keys) cJSON_free(s->keys[i]);if (s->nested) cJSON_DeleteSchema(s->nested[i]);}
+	cJSON_free(s->namelen);cJSON_free(s->keys);cJSON_free(s->keylen);cJSON_free(s->nested);cJSON_free(s->slots);
+	cJSON_free(s);
+}
+
+/* Is the member the right size for its type? */
+static int bind_check(const cJSON_Field *f)
+{
+	if ((f->type&cJSON_BindArray) && f->max<=0) return 0;
+	switch (f->type&~cJSON_BindArray)
+	{
+		case cJSON_BindInt:	case cJSON_BindBool:	return f->size==sizeof(int);
+		case cJSON_BindDouble:						return f->size==sizeof(double);
+		case cJSON_BindString:						return f->size==sizeof(char*);
+		case cJSON_BindChars:						return f->size>0;
+		case cJSON_BindStruct:						return f->fields!=0;
+	}
+	return 0;
+}
+
+/* Find a seed under which every name has a slot to itself, growing the table if none will do. */
+static int bind_perfect_hash(cJSON_Schema *s)
+{
+	unsigned size,seed,h;int i;
+	for (size=8;size<(unsigned)s->count*2;size*=2);
+	for (;size<=65536;size*=2)
+	{
+		if (!(s->slots=(int*)cJSON_malloc(size*sizeof(int)))) return 0;
+		for (seed=0;seed<256;seed++)
+		{
+			memset(s->slots,-1,size*sizeof(int));
+			s->seed=2166136261u+seed*0x9e3779b9u;s->mask=size-1;
+			for (i=0;i<s->count;i++)
+			{
+				h=hash_mix(hash_bytes(s->seed,s->fields[i].name,s->namelen[i]))&s->mask;
+				if (s->slots[h]>=0) break;
+				s->slots[h]=i;
+			}
+			if (i==s->count) return 1;
+		}
+		cJSON_free(s->slots);s->slots=0;
+	}
+	return 0;
+}
+
+cJSON_Schema *cJSON_CompileSchema(const cJSON_Field *fields)
+{
+	cJSON_Schema *s;int i,j,n=0;size_t len;
+	if (!fields) return 0;
+	while (fields[n].name) n++;
+	if (!(s=(cJSON_Schema*)cJSON_malloc(sizeof(cJSON_Schema)))) return 0;
+	memset(s,0,sizeof(cJSON_Schema));
+	s->fields=fields;
+	s->namelen=(size_t*)cJSON_malloc((n+1)*sizeof(size_t));
+	s->keylen=(size_t*)cJSON_malloc((n+1)*sizeof(size_t));
+	s->keys=(char**)cJSON_malloc((n+1)*sizeof(char*));
+	s->nested=(cJSON_Schema**)cJSON_malloc((n+1)*sizeof(cJSON_Schema*));
+	if (!s->namelen || !s->keylen || !s->keys || !s->nested) {cJSON_DeleteSchema(s);return 0;}
+	memset(s->keys,0,(n+1)*sizeof(char*));memset(s->nested,0,(n+1)*sizeof(cJSON_Schema*));
+	s->count=n;
+	for (i=0;i<n;i++)
+	{
+		if (!bind_check(fields+i)) {cJSON_DeleteSchema(s);return 0;}
+		for (j=0;j<i;j++) if (!strcmp(fields[i].name,fields[j].name)) {cJSON_DeleteSchema(s);return 0;}
+		len=s->namelen[i]=strlen(fields[i].name);
+		/* The key is printed once, here: "name": */
+		s->keylen[i]=escaped_size((const unsigned char*)fields[i].name,len,0)+3;
+		if (!(s->keys[i]=(char*)cJSON_malloc(s->keylen[i]+1))) {cJSON_DeleteSchema(s);return 0;}
+		s->keys[i][0]='\"';
+		strcpy(escape_into(s->keys[i]+1,(const unsigned char*)fields[i].name,len,0),"\":");
+		if ((fields[i].type&~cJSON_BindArray)==cJSON_BindStruct && !(s->nested[i]=cJSON_CompileSchema(fields[i].fields))) {cJSON_DeleteSchema(s);return 0;}
+	}
+	if (!bind_perfect_hash(s)) {cJSON_DeleteSchema(s);return 0;}
+	return s;
+}
+
+static int bind_find(cJSON_Schema *s,const char *name,size_t len)
+{
+	int i=s->slots[hash_mix(hash_bytes(s->seed,name,len))&s->mask];
+	return (i>=0 && s->namelen[i]==len && !memcmp(s->fields[i].name,name,len))?i:-1;
+}
+
+/* The binding parser reads nothing at or past end, so text need not be null terminated. Failures set ep and return 0. */
+static const char *bind_fail(const char *at)						{ep=at;return 0;}
+static const char *bind_ws(const char *p,const char *end)			{while (p && p<end && (unsigned char)*p<=32) p++;return p;}
+static int bind_literal(const char *p,const char *end,const char *word)	{size_t n=strlen(word);return (size_t)(end-p)>=n && !strncmp(p,word,n);}
+
+/* Decode the string at str like parse_string does, into out if it isn't 0. *outlen gets the decoded length.
+Returns the position past the closing quote, or 0 if there is none before end. */
+static const char *bind_string(const char *str,const char *end,char *out,size_t *outlen)
+{
+	const char *ptr=str+1;size_t n=0;unsigned uc,uc2;char c;
+	if (str>=end || *str!='\"') return 0;
+	while (ptr<end && *ptr!='\"')
+	{
+		c=*ptr;
+		if (c=='\\')
+		{
+			if (++ptr>=end) return 0;
+			switch (*ptr)
+			{
+				case 'b': c='\b';	break;
+				case 'f': c='\f';	break;
+				case 'n': c='\n';	break;
+				case 'r': c='\r';	break;
+				case 't': c='\t';	break;
+				case 'u':
+					if (end-ptr<5) return 0;
+					uc=parse_hex4(ptr+1);ptr+=5;
+					if ((uc>=0xDC00 && uc<=0xDFFF) || uc==0)	continue;	/* check for invalid.	*/
+					if (uc>=0xD800 && uc<=0xDBFF)	/* UTF16 surrogate pairs.	*/
+					{
+						if (end-ptr<6 || ptr[0]!='\\' || ptr[1]!='u')	continue;
+						uc2=parse_hex4(ptr+2);ptr+=6;
+						if (uc2<0xDC00 || uc2>0xDFFF)		continue;
+						uc=0x10000 + (((uc&0x3FF)<<10) | (uc2&0x3FF));
+					}
+					n+=utf8_encode(out?out+n:0,uc);
+					continue;
+				default: c=*ptr; break;
+			}
+		}
+		if (out) out[n]=c;
+		n++;ptr++;
+	}
+	if (ptr>=end) return 0;
+	*outlen=n;
+	return ptr+1;
+}
+
+/* Step over a value nothing is bound to. This checks only enough to find where the value ends. */
+static const char *bind_skip(const char *p,const char *end)
+{
+	int depth=0;size_t n;const char *start;
+	do
+	{
+		p=bind_ws(p,end);
+		if (p>=end)											return bind_fail(p);
+		if (*p=='\"')										{if (!(p=bind_string(p,end,0,&n))) return bind_fail(end);}
+		else if (*p=='[' || *p=='{')						depth++,p++;
+		else if (*p==']' || *p=='}')						{if (!depth) return bind_fail(p);depth--,p++;}
+		else if (*p==',' || *p==':')						{if (!depth) return bind_fail(p);p++;}
+		else
+		{
+			for (start=p;p<end && (unsigned char)*p>32 && !strchr(",:[]{}\"",*p);p++);
+			if (p==start)									return bind_fail(p);
+		}
+	} while (depth);
+	return p;
+}
+
+static void bind_free(cJSON_Schema *s,char *obj);
+/* Release the strings member i of obj holds, its nested structs' included. An array member is left empty. */
+static void bind_free_member(cJSON_Schema *s,int i,char *obj)
+{
+	const cJSON_Field *f=s->fields+i;int j,n;char *at;
+	n=(f->type&cJSON_BindArray)?*(int*)(obj+f->count):1;
+	if (n>f->max && (f->type&cJSON_BindArray)) n=f->max;
+	for (j=0;j<n;j++)
+	{
+		at=obj+f->offset+j*f->size;
+		if ((f->type&~cJSON_BindArray)==cJSON_BindString)		{cJSON_free(*(char**)at);*(char**)at=0;}
+		else if ((f->type&~cJSON_BindArray)==cJSON_BindStruct)	bind_free(s->nested[i],at);
+	}
+	if (f->type&cJSON_BindArray) *(int*)(obj+f->count)=0;
+}
+static void bind_free(cJSON_Schema *s,char *obj)	{int i;for (i=0;i<s->count;i++) bind_free_member(s,i,obj);}
+
+static const char *bind_parse_struct(cJSON_Schema *s,const char *p,const char *end,char *out);
+/* Parse one value of the given type into at. */
+static const char *bind_parse_value(cJSON_Schema *s,int i,const char *p,const char *end,char *at)
+{
+	const cJSON_Field *f=s->fields+i;char num[64],*str;size_t n;cJSON item;
+	if (bind_literal(p,end,"null")) return p+4;	/* leave it as it was */
+	switch (f->type&~cJSON_BindArray)
+	{
+		case cJSON_BindInt: case cJSON_BindDouble:
+			for (n=0;p+n<end && n<sizeof(num)-1 && p[n] && strchr("+-.eE0123456789",p[n]);n++) num[n]=p[n];
+			num[n]=0;
+			str=num+(*num=='-');
+			if (!(*str>='0' && *str<='9') || parse_number(&item,num)!=num+n) return bind_fail(p);
+			if ((f->type&~cJSON_BindArray)==cJSON_BindDouble)	{*(double*)at=item.valuedouble;return p+n;}
+			if (item.valuedouble!=floor(item.valuedouble) || item.valuedouble<INT_MIN || item.valuedouble>INT_MAX) return bind_fail(p);	/* no int holds it */
+			*(int*)at=(int)item.valuedouble;
+			return p+n;
+		case cJSON_BindBool:
+			if (bind_literal(p,end,"true"))		{*(int*)at=1;return p+4;}
+			if (bind_literal(p,end,"false"))	{*(int*)at=0;return p+5;}
+			return bind_fail(p);
+		case cJSON_BindChars:
+			if (!bind_string(p,end,0,&n) || n>=f->size) return bind_fail(p);
+			p=bind_string(p,end,at,&n);at[n]=0;
+			return p;
+		case cJSON_BindString:
+			if (!bind_string(p,end,0,&n)) return bind_fail(p);
+			if (!(str=(char*)cJSON_malloc(n+1))) return 0;
+			p=bind_string(p,end,str,&n);str[n]=0;
+			if (*(char**)at) cJSON_free(*(char**)at);
+			*(char**)at=str;
+			return p;
+		case cJSON_BindStruct:
+			return bind_parse_struct(s->nested[i],p,end,at);
+	}
+	return bind_fail(p);
+}
+
+/* Parse a member's value: one value, or for an array member, a list of them with the count kept up to date as it goes. */
+static const char *bind_parse_member(cJSON_Schema *s,int i,const char *p,const char *end,char *out)
+{
+	const cJSON_Field *f=s->fields+i;int *count;
+	if (!(f->type&cJSON_BindArray)) return bind_parse_value(s,i,p,end,out+f->offset);
+	if (bind_literal(p,end,"null")) return p+4;
+	if (p>=end || *p!='[') return bind_fail(p);
+	count=(int*)(out+f->count);bind_free_member(s,i,out);	/* a repeated member replaces the elements before */
+	p=bind_ws(p+1,end);
+	if (p<end && *p==']') return p+1;
+	for (;;)
+	{
+		if (*count>=f->max) return bind_fail(p);	/* no room */
+		p=bind_ws(bind_parse_value(s,i,p,end,out+f->offset+(*count)++*f->size),end);
+		if (!p) return 0;
+		if (p>=end) return bind_fail(p);
+		if (*p==']') return p+1;
+		if (*p!=',') return bind_fail(p);
+		p=bind_ws(p+1,end);
+	}
+}
+
+/* Read a member name and look it up; *field gets -1 if nothing is bound to it. */
+static const char *bind_key(cJSON_Schema *s,const char *p,const char *end,int *field)
+{
+	const char *q;char small[256],*name;size_t n;
+	if (!(q=bind_string(p,end,0,&n))) return bind_fail(p);
+	if (!memchr(p+1,'\\',q-p-2)) {*field=bind_find(s,p+1,n);return q;}
+	/* A name with escapes in it is decoded first. */
+	if (n<sizeof(small)) name=small;
+	else if (!(name=(char*)cJSON_malloc(n))) return 0;
+	bind_string(p,end,name,&n);
+	*field=bind_find(s,name,n);
+	if (name!=small) cJSON_free(name);
+	return q;
+}
+
+static const char *bind_parse_struct(cJSON_Schema *s,const char *p,const char *end,char *out)
+{
+	int i;
+	if (p>=end || *p!='{') return bind_fail(p);
+	p=bind_ws(p+1,end);
+	if (p<end && *p=='}') return p+1;
+	for (;;)
+	{
+		p=bind_ws(bind_key(s,p,end,&i),end);
+		if (!p) return 0;
+		if (p>=end || *p!=':') return bind_fail(p);
+		p=bind_ws(p+1,end);
+		p=bind_ws((i<0)?bind_skip(p,end):bind_parse_member(s,i,p,end,out),end);
+		if (!p) return 0;
+		if (p>=end) return bind_fail(p);
+		if (*p=='}') return p+1;
+		if (*p!=',') return bind_fail(p);
+		p=bind_ws(p+1,end);
+	}
+}
+
+int cJSON_ParseInto(cJSON_Schema *schema,const char *text,size_t len,void *out)
+{
+	const char *end=text+len,*p;
+	ep=0;
+	if (!schema || !text || !out) return 1;
+	p=bind_ws(bind_parse_struct(schema,bind_ws(text,end),end,(char*)out),end);
+	if (!p) return 1;
+	if (p<end) {ep=p;return 1;}
+	return 0;
+}
+
+/* The binding printer appends to one growing buffer. It is freed and set to 0 on memory fail, after which appends do nothing. */
+typedef struct {char *buf;size_t len,size;} bind_buffer;
+static char *bind_reserve(bind_buffer *b,size_t n)
+{
+	char *grown;
+	if (!b->buf) return 0;
+	if (b->len+n+1>b->size)
+	{
+		b->size=b->size*2+n+1;
+		if (!(grown=(char*)cJSON_malloc(b->size))) {cJSON_free(b->buf);b->buf=0;return 0;}
+		memcpy(grown,b->buf,b->len);cJSON_free(b->buf);b->buf=grown;
+	}
+	return b->buf+b->len;
+}
+static void bind_put(bind_buffer *b,const char *str,size_t n)	{char *at=bind_reserve(b,n);if (at) memcpy(at,str,n),b->len+=n;}
+static void bind_put_string(bind_buffer *b,const char *str,size_t len)
+{
+	char *at=bind_reserve(b,escaped_size((const unsigned char*)str,len,0)+2);
+	if (!at) return;
+	*at++='\"';at=escape_into(at,(const unsigned char*)str,len,0);*at++='\"';
+	b->len=at-b->buf;
+}
+
+static void bind_print_struct(cJSON_Schema *s,const char *in,bind_buffer *b);
+static void bind_print_value(cJSON_Schema *s,int i,const char *at,bind_buffer *b)
+{
+	const cJSON_Field *f=s->fields+i;char num[64];const char *str;double d;
+	switch (f->type&~cJSON_BindArray)
+	{
+		case cJSON_BindInt:		sprintf(num,"%d",*(const int*)at);bind_put(b,num,strlen(num));break;
+		case cJSON_BindDouble:	d=*(const double*)at;format_number(num,d,(d<=INT_MAX && d>=INT_MIN)?(int)d:0);bind_put(b,num,strlen(num));break;
+		case cJSON_BindBool:	if (*(const int*)at) bind_put(b,"true",4); else bind_put(b,"false",5);break;
+		case cJSON_BindString:	if ((str=*(char*const*)at)) bind_put_string(b,str,strlen(str)); else bind_put(b,"null",4);break;
+		case cJSON_BindChars:	str=(const char*)memchr(at,0,f->size);bind_put_string(b,at,str?(size_t)(str-at):f->size);break;
+		case cJSON_BindStruct:	bind_print_struct(s->nested[i],at,b);break;
+	}
+}
+static void bind_print_struct(cJSON_Schema *s,const char *in,bind_buffer *b)
+{
+	const cJSON_Field *f;int i,j,n;
+	bind_put(b,"{",1);
+	for (i=0;i<s->count;i++)
+	{
+		f=s->fields+i;
+		if (i) bind_put(b,",",1);
+		bind_put(b,s->keys[i],s->keylen[i]);
+		if (!(f->type&cJSON_BindArray)) {bind_print_value(s,i,in+f->offset,b);continue;}
+		n=*(const int*)(in+f->count);if (n>f->max) n=f->max;
+		bind_put(b,"[",1);
+		for (j=0;j<n;j++) {if (j) bind_put(b,",",1);bind_print_value(s,i,in+f->offset+j*f->size,b);}
+		bind_put(b,"]",1);
+	}
+	bind_put(b,"}",1);
+}
+
+char *cJSON_PrintFrom(cJSON_Schema *schema,const void *in)
+{
+	bind_buffer b;
+	if (!schema || !in) return 0;
+	b.len=0;b.size=256;
+	if (!(b.buf=(char*)cJSON_malloc(b.size))) return 0;
+	bind_print_struct(schema,(const char*)in,&b);
+	if (b.buf) b.buf[b.len]=0;
+	return b.buf;
+}
+
+void cJSON_FreeBound(cJSON_Schema *schema,void *obj)	{if (schema && obj) bind_free(schema,(char*)obj);}
@@ -23,6 +23,8 @@
 #ifndef cJSON__h
 #define cJSON__h
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -38,17 +40,22 @@ extern "C"
 #define cJSON_Object 6
 	
 #define cJSON_IsReference 256
+#define cJSON_IsPacked 512
 
 /* The cJSON structure: */
 typedef struct cJSON {
 	struct cJSON *next,*prev;	/* next/prev allow you to walk array/object chains. Alternatively, use GetArraySize/GetArrayItem/GetObjectItem */
 	struct cJSON *child;		/* An array or object item will have a child pointer pointing to a chain of the items in the array/object. */
+	struct cJSON *parent;		/* The array/object whose chain this item is in, or 0. Kept by the cJSON API, so caches above a change can be dropped. */
 
 	int type;					/* The type of the item, as above. */
+	int shared;					/* How many other items also own the chain starting here; see cJSON_DuplicateShared. */
 
-	char *valuestring;			/* The item's string, if type==cJSON_String */
+	char *valuestring;			/* The item's string, if type==cJSON_String (a packed array keeps its numbers here; see cJSON_GetDoubleArrayData) */
 	int valueint;				/* The item's number, if type==cJSON_Number */
+	unsigned hash;				/* An array/object's cached cJSON_Hash shifted up 3 bits, over the flags it was computed with, or 0. */
 	double valuedouble;			/* The item's number, if type==cJSON_Number */
+	struct cJSON_Rendered *rendered;	/* Where cJSON_PrintCached keeps an array/object's text, or 0. */
 
 	char *string;				/* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
 } cJSON;
@@ -60,6 +67,31 @@ typedef struct cJSON_Hooks {
 
 /* Supply malloc, realloc and free functions to cJSON */
 extern void cJSON_InitHooks(cJSON_Hooks* hooks);
+/* Allocate and free through those hooks, as cJSON itself does (and counted the same by cJSON_GetStats). */
+extern void *cJSON_Malloc(size_t sz);
+extern void cJSON_Free(void *ptr);
+
+/* Parse/print statistics, kept per thread. These are only collected when cJSON.c is compiled with -DCJSON_STATS; otherwise they always read as zero. */
+typedef struct cJSON_Stats {
+	unsigned long nodes[7];		/* Values parsed, indexed by type (cJSON_False..cJSON_Object); the numbers in a packed array count too. */
+	unsigned long string_bytes;	/* Bytes of decoded string data, values and names alike. */
+	int max_depth;				/* Deepest array/object nesting seen by the parser. */
+
+	unsigned long allocs,alloc_bytes;	/* Calls through the malloc hook, and the bytes requested. */
+	unsigned long frees,free_bytes;		/* Calls through the free hook, and the bytes those blocks were allocated with. So alloc_bytes-free_bytes
+										is what cJSON still holds, plus the printed text it has handed back for you to free.
+										A block freed on another thread than it was allocated on, or allocated before the last
+										cJSON_ResetStats, counts as a free of 0 bytes. */
+
+	double parse_time;			/* Seconds spent in the parse functions, */
+	double string_time;			/* of which decoding strings, */
+	double number_time;			/* and converting numbers. */
+	double print_time;			/* Seconds spent in the print functions. */
+} cJSON_Stats;
+
+/* Copy the calling thread's statistics into stats / zero them. */
+extern void cJSON_GetStats(cJSON_Stats *stats);
+extern void cJSON_ResetStats(void);
 
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
@@ -68,6 +100,21 @@ extern cJSON *cJSON_Parse(const char *value);
 extern char  *cJSON_Print(cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. Free the char* when finished. */
 extern char  *cJSON_PrintUnformatted(cJSON *item);
+/* Render with options: PrintFormatted is cJSON_Print's layout, PrintASCII escapes everything past 0x7f as \uXXXX (UTF-16 pairs above 0xffff),
+and each byte that is not valid UTF-8 as \ufffd. */
+#define cJSON_PrintFormatted	1
+#define cJSON_PrintASCII		2
+/* PrintCached (unformatted, non-ASCII prints only) keeps each array/object's text and reuses it until something under the
+container is changed through the cJSON API: a change drops the text of every array/object above it, through ->parent.
+The text is kept once: an array/object inside one that keeps its text only notes where in that text its own lies.
+In a tree from cJSON_DuplicateShared, reach what you change with the ForWrite calls, which keep ->parent right. */
+#define cJSON_PrintCached		4
+extern char  *cJSON_PrintWithOpts(cJSON *item,int opts);
+/* Drop the cached text and hash of item and of every array/object above it, after item was changed in place
+(its value set directly, say). This follows ->parent, and stops where that is 0 or leads elsewhere, as it can in a tree
+from cJSON_DuplicateShared that was not reached with the ForWrite calls: an array/object whose children do not all name
+it as their parent never keeps its text or hash, so none is left stale above that point. */
+extern void cJSON_MarkDirty(cJSON *item);
 /* Delete a cJSON entity and all subentities. */
 extern void   cJSON_Delete(cJSON *c);
 
@@ -77,6 +124,12 @@ extern int	  cJSON_GetArraySize(cJSON *array);
 extern cJSON *cJSON_GetArrayItem(cJSON *array,int item);
 /* Get item "string" from object. Case insensitive. */
 extern cJSON *cJSON_GetObjectItem(cJSON *object,const char *string);
+/* The same, for an item you are about to change in place. These first give the array/object a private chain of
+children if it shares one (see cJSON_DuplicateShared), unpack it if it is packed, and drop its cached hash and text.
+They return NULL on memory fail, or when array/object itself was reached through children it shares.
+GetArrayItem/GetObjectItem themselves only read, and hand out nothing from a packed array. */
+extern cJSON *cJSON_GetArrayItemForWrite(cJSON *array,int item);
+extern cJSON *cJSON_GetObjectItemForWrite(cJSON *object,const char *string);
 
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 extern const char *cJSON_GetErrorPtr(void);
@@ -96,13 +149,29 @@ extern cJSON *cJSON_CreateIntArray(const int *numbers,int count);
 extern cJSON *cJSON_CreateFloatArray(const float *numbers,int count);
 extern cJSON *cJSON_CreateDoubleArray(const double *numbers,int count);
 extern cJSON *cJSON_CreateStringArray(const char **strings,int count);
+/* The same for numbers, packed: see cJSON_IsPacked below. */
+extern cJSON *cJSON_CreatePackedIntArray(const int *numbers,int count);
+extern cJSON *cJSON_CreatePackedFloatArray(const float *numbers,int count);
+extern cJSON *cJSON_CreatePackedDoubleArray(const double *numbers,int count);
+
+/* Packed arrays keep their numbers in one block (at ->valuestring, as they have no string) instead of a chain of items, so ->child is 0.
+cJSON_GetArraySize, the print functions, Duplicate, Hash and Equal read them as they are; cJSON_GetArrayItem finds no
+items in one. Anything that hands out an item of one to change or changes it (GetArrayItemForWrite and the
+Add/Detach/Delete/Replace calls) first turns it back into an ordinary array. */
+/* The numbers of a packed array, in place and read-only, or 0 if array is not packed. Index these rather than asking for
+items: GetArrayItemForWrite on a packed array unpacks all of it, at the cost of an item per number. */
+extern double *cJSON_GetDoubleArrayData(cJSON *array);
+/* Copy up to max numbers out of an array, packed or not. Returns how many were copied, or -1 if it holds anything but numbers. */
+extern int cJSON_GetDoubleArray(cJSON *array,double *numbers,int max);
+extern int cJSON_GetIntArray(cJSON *array,int *numbers,int max);
 
-/* Append item to the specified array/object. */
-extern void cJSON_AddItemToArray(cJSON *array, cJSON *item);
-extern void	cJSON_AddItemToObject(cJSON *object,const char *string,cJSON *item);
+/* Append item to the specified array/object. The Add, Insert and Replace calls return 1 once item is in place, and 0 on
+memory fail or when the array/object was reached through children it shares (see cJSON_DuplicateShared): you still own item then. */
+extern int cJSON_AddItemToArray(cJSON *array, cJSON *item);
+extern int	cJSON_AddItemToObject(cJSON *object,const char *string,cJSON *item);
 /* Append reference to item to the specified array/object. Use this when you want to add an existing cJSON to a new cJSON, but don't want to corrupt your existing cJSON. */
-extern void cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item);
-extern void	cJSON_AddItemReferenceToObject(cJSON *object,const char *string,cJSON *item);
+extern int cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item);
+extern int	cJSON_AddItemReferenceToObject(cJSON *object,const char *string,cJSON *item);
 
 /* Remove/Detatch items from Arrays/Objects. */
 extern cJSON *cJSON_DetachItemFromArray(cJSON *array,int which);
@@ -111,17 +180,83 @@ extern cJSON *cJSON_DetachItemFromObject(cJSON *object,const char *string);
 extern void   cJSON_DeleteItemFromObject(cJSON *object,const char *string);
 	
 /* Update array items. */
-extern void cJSON_ReplaceItemInArray(cJSON *array,int which,cJSON *newitem);
-extern void cJSON_ReplaceItemInObject(cJSON *object,const char *string,cJSON *newitem);
+extern int cJSON_InsertItemInArray(cJSON *array,int which,cJSON *newitem);	/* Shifts pre-existing items to the right. */
+extern int cJSON_ReplaceItemInArray(cJSON *array,int which,cJSON *newitem);
+extern int cJSON_ReplaceItemInObject(cJSON *object,const char *string,cJSON *newitem);
 
 /* Duplicate a cJSON item */
 extern cJSON *cJSON_Duplicate(cJSON *item,int recurse);
 /* Duplicate will create a new, identical cJSON item to the one you pass, in new memory that will
 need to be released. With recurse!=0, it will duplicate any children connected to the item.
 The item->next and ->prev pointers are always zero on return from Duplicate. */
+/* DuplicateShared returns a recursive copy in constant time: the new item shares the children of the one you pass.
+A shared chain is copied one level at a time, only when something wants to change it: the Add/Detach/Delete/Replace
+calls and cJSON_GetArrayItemForWrite/cJSON_GetObjectItemForWrite give the array/object they are handed a private chain
+first. So to modify a shared tree, walk down to what you change with the ForWrite calls rather than with the read-only
+Get calls or ->child/->next; only the items along that path get copied. Reading copies nothing. A change below a shared
+chain that was reached otherwise would show in every tree that has it, so the calls refuse it and fail instead.
+cJSON_Delete frees shared children once their last owner is gone. The counts that track this are plain ints: use a tree
+and every copy that shares with it from one thread at a time, even where each thread changes only its own copy. */
+extern cJSON *cJSON_DuplicateShared(cJSON *item);
+/* Whether item was reached through children shared with another tree, so a change to it in place would show there too. */
+extern int cJSON_IsShared(cJSON *item);
+
+/* Hash or compare items by walking them, without printing. Objects' member names are compared case sensitively here. */
+#define cJSON_HashUnordered	1	/* Objects hash/compare the same whatever order their members are in. */
+#define cJSON_HashExact		2	/* Numbers must match bit for bit, so 0 and -0 differ. Otherwise they compare with ==. */
+#define cJSON_HashCache		4	/* Keep the hash of every array/object, so subtrees that have not changed are not walked again. */
+/* The hash is 29 bits wide. */
+extern unsigned cJSON_Hash(cJSON *item,int flags);
+extern int cJSON_Equal(cJSON *a,cJSON *b,int flags);
+/* A cached hash is dropped when its array/object is changed through the Add/Detach/Delete/Replace calls or handed out by
+cJSON_GetArrayItemForWrite/cJSON_GetObjectItemForWrite, so reach what you change through those and every cache above it goes too. */
 
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 extern cJSON *cJSON_ParseWithOpts(const char *value,const char **return_parse_end,int require_null_terminated);
+/* ParseWithFlags takes the same option as a flag, along with ParsePackNumbers, which packs every array that holds nothing but numbers. */
+#define cJSON_ParseRequireNullTerminated	1
+#define cJSON_ParsePackNumbers				2
+extern cJSON *cJSON_ParseWithFlags(const char *value,const char **return_parse_end,int flags);
+
+/* Struct binding: parse JSON straight into C structs and print them back, without building any cJSON items.
+Describe each struct with a table of cJSON_Field, made with the cJSON_Bind* macros and ended by cJSON_BindEnd: */
+#define cJSON_BindInt		1	/* int; a number with a fraction, or out of range, fails the parse. */
+#define cJSON_BindDouble	2	/* double */
+#define cJSON_BindBool		3	/* int, 0 or 1 */
+#define cJSON_BindString	4	/* char *, allocated through the hooks; release it with cJSON_FreeBound. */
+#define cJSON_BindChars		5	/* char[N]; a string that does not fit fails the parse. */
+#define cJSON_BindStruct	6	/* A nested struct, with a table of its own. */
+#define cJSON_BindArray		16	/* Or'd with one of the above: T member[N], plus an int member holding how many are in use. */
+
+typedef struct cJSON_Field {
+	const char *name;					/* The member's name in the JSON text (matched case sensitively). */
+	int type;							/* cJSON_Bind*, as above. */
+	size_t offset,size;					/* Where the member is in the struct and its size - for arrays, the size of one element. */
+	int max;							/* How many elements an array member has room for. */
+	size_t count;						/* Where an array's int count is in the struct. */
+	const struct cJSON_Field *fields;	/* The table of a nested struct. */
+} cJSON_Field;
+
+#define cJSON_BindNamed(name,st,member,type)				{name,type,offsetof(st,member),sizeof(((st*)0)->member),0,0,0}
+#define cJSON_BindField(st,member,type)						cJSON_BindNamed(#member,st,member,type)
+#define cJSON_BindNested(st,member,fields)					{#member,cJSON_BindStruct,offsetof(st,member),sizeof(((st*)0)->member),0,0,fields}
+#define cJSON_BindList(st,member,type,countmember,fields)	{#member,(type)|cJSON_BindArray,offsetof(st,member),sizeof(((st*)0)->member[0]),\
+															sizeof(((st*)0)->member)/sizeof(((st*)0)->member[0]),offsetof(st,countmember),fields}
+#define cJSON_BindEnd										{0,0,0,0,0,0,0}
+
+/* Compile a table once, up front: this checks it and builds the key lookup (a perfect hash). Returns 0 for a bad table
+(a member of the wrong size for its type, say, or a name used twice) or on memory fail. The table must outlive the schema. */
+typedef struct cJSON_Schema cJSON_Schema;
+extern cJSON_Schema *cJSON_CompileSchema(const cJSON_Field *fields);
+extern void cJSON_DeleteSchema(cJSON_Schema *schema);
+/* Parse the len bytes of text, which must hold one object, into *out. Start from a zeroed struct: members the text does
+not mention, or gives as null, are left as they were, and unknown members are skipped. Returns 0 on success; otherwise
+cJSON_GetErrorPtr says where it failed, and out may be partly filled. Either way, cJSON_FreeBound releases its strings. */
+extern int cJSON_ParseInto(cJSON_Schema *schema,const char *text,size_t len,void *out);
+/* Render *in as unformatted JSON, members in table order. Free the char* when finished. */
+extern char *cJSON_PrintFrom(cJSON_Schema *schema,const void *in);
+/* Free the strings held by *obj and zero those pointers and the array counts, ready to parse into again. */
+extern void cJSON_FreeBound(cJSON_Schema *schema,void *obj);
 
 extern void cJSON_Minify(char *json);
 
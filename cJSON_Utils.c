@@ -0,0 +1,601 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* cJSON Utils */
+/* JSON Pointer, JSON Patch and JSON Merge Patch on top of cJSON. */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "cJSON_Utils.h"
+
+/* Member names are compared case sensitively throughout, as the RFCs require. */
+static int name_equal(const char *a,const char *b)	{return !strcmp(a?a:"",b?b:"");}
+static unsigned name_hash(const char *str)			{unsigned h=2166136261u;if (str) while (*str) h=(h^(unsigned char)*str++)*16777619u;return h;}
+
+/* Read-only lookup of a member, for picking apart patch documents. */
+static cJSON *member(cJSON *object,const char *name)	{cJSON *c=object?object->child:0;while (c && !name_equal(c->string,name)) c=c->next;return c;}
+/* Position of the first member called name, or -1. */
+static int member_index(cJSON *object,const char *name)	{int i=0;cJSON *c=object->child;while (c && !name_equal(c->string,name)) i++,c=c->next;return c?i:-1;}
+
+/* An RFC6901 array index: digits without leading zeros. -1 if str is anything else. */
+static int array_index(const char *str)
+{
+	int i=0;
+	if (!*str || (*str=='0' && str[1])) return -1;
+	for (;*str;str++) {if (*str<'0' || *str>'9' || i>(0x7fffffff-9)/10) return -1;i=i*10+(*str-'0');}
+	return i;
+}
+
+/* Decode the pointer segment between ptr (just past a '/') and the next '/' or end into out, undoing ~0 and ~1.
+out needs room for the raw segment and a terminator. Returns the decoded length, or -1 if a ~ is misused. */
+static int decode_into(const char *ptr,const char *end,char *out,const char **next)
+{
+	const char *stop=ptr;char *o=out;
+	while (stop<end && *stop!='/') stop++;
+	for (;ptr<stop;ptr++)
+	{
+		if (*ptr!='~') *o++=*ptr;
+		else if (ptr+1<stop && (ptr[1]=='0' || ptr[1]=='1')) *o++=(*++ptr=='0')?'~':'/';
+		else return -1;	/* ~ must be followed by 0 or 1. */
+	}
+	*o=0;*next=stop;
+	return (int)(o-out);
+}
+/* The same, into a string of its own. Free the result. */
+static char *decode_segment(const char *ptr,const char *end,const char **next)
+{
+	const char *stop=ptr;char *out;
+	while (stop<end && *stop!='/') stop++;
+	if (!(out=(char*)cJSON_Malloc(stop-ptr+1))) return 0;
+	if (decode_into(ptr,end,out,next)<0) {cJSON_Free(out);return 0;}
+	return out;
+}
+
+/* Step from item to the child named by seg. With write, this goes through cJSON_GetArrayItemForWrite so shared children are copied first. */
+static cJSON *child_of(cJSON *item,const char *seg,int write)
+{
+	int i=-1;
+	if ((item->type&255)==cJSON_Array)			i=array_index(seg);
+	else if ((item->type&255)==cJSON_Object)	i=member_index(item,seg);
+	if (i<0) return 0;
+	return write?cJSON_GetArrayItemForWrite(item,i):cJSON_GetArrayItem(item,i);
+}
+
+/* Follow the pointer from ptr up to end. */
+static cJSON *walk(cJSON *item,const char *ptr,const char *end,int write)
+{
+	char *seg;
+	while (item && ptr<end)
+	{
+		if (*ptr!='/' || !(seg=decode_segment(ptr+1,end,&ptr))) return 0;
+		item=child_of(item,seg,write);
+		cJSON_Free(seg);
+	}
+	return item;
+}
+
+cJSON *cJSON_GetPointer(cJSON *object,const char *pointer)	{return (object && pointer)?walk(object,pointer,pointer+strlen(pointer),0):0;}
+/* The same inside a patch's working copy, where packed arrays may be unpacked to reach their items. */
+static cJSON *find(cJSON *root,const char *pointer)			{return walk(root,pointer,pointer+strlen(pointer),1);}
+
+/* Resolve everything but the last segment of pointer, and decode that last segment into *seg. */
+static cJSON *walk_parent(cJSON *root,const char *pointer,char **seg)
+{
+	const char *last=strrchr(pointer,'/'),*end;cJSON *parent;
+	*seg=0;
+	if (!last || !(parent=walk(root,pointer,last,1))) return 0;
+	if (!(*seg=decode_segment(last+1,last+1+strlen(last+1),&end))) return 0;
+	return parent;
+}
+
+/* Exchange the values of two items, leaving their names and list links where they are. */
+static void swap_contents(cJSON *a,cJSON *b)
+{
+	cJSON t=*a,*c;
+	a->type=b->type;a->child=b->child;a->valuestring=b->valuestring;a->valueint=b->valueint;a->valuedouble=b->valuedouble;a->hash=b->hash;
+	b->type=t.type;b->child=t.child;b->valuestring=t.valuestring;b->valueint=t.valueint;b->valuedouble=t.valuedouble;b->hash=t.hash;
+	a->rendered=b->rendered;b->rendered=t.rendered;
+	if (!(b->type&cJSON_IsReference)) for (c=b->child;c;c=c->next) c->parent=b;
+	if (!(a->type&cJSON_IsReference)) for (c=a->child;c;c=c->next) c->parent=a;	/* after b's, as the two may share a chain. */
+	cJSON_MarkDirty(a->parent);	/* a's own caches came with its new value; the ones above it no longer hold. */
+}
+
+/* Give item the name it will have inside an object. */
+static int set_name(cJSON *item,const char *name)
+{
+	char *copy=(char*)cJSON_Malloc(strlen(name)+1);
+	if (!copy) return 0;
+	strcpy(copy,name);
+	if (item->string) cJSON_Free(item->string);
+	item->string=copy;
+	return 1;
+}
+
+/* Put value at pointer, as the "add" op does: insert into arrays, add or replace in objects. Takes value in all cases. */
+static int insert_at(cJSON *root,const char *pointer,cJSON *value)
+{
+	cJSON *parent;char *seg;int i,status=0;
+	if (!value) return 1;
+	if (!*pointer) {swap_contents(root,value);cJSON_Delete(value);return 0;}
+	if (!(parent=walk_parent(root,pointer,&seg))) {cJSON_Free(seg);cJSON_Delete(value);return 2;}
+	if ((parent->type&255)==cJSON_Array)
+	{
+		if (!strcmp(seg,"-")) status=!cJSON_AddItemToArray(parent,value);
+		else if ((i=array_index(seg))>=0 && i<=cJSON_GetArraySize(parent)) status=!cJSON_InsertItemInArray(parent,i,value);
+		else status=2;
+	}
+	else if ((parent->type&255)==cJSON_Object)
+	{
+		if ((i=member_index(parent,seg))<0) status=!cJSON_AddItemToObject(parent,seg,value);
+		else if (set_name(value,seg)) status=!cJSON_ReplaceItemInArray(parent,i,value);
+		else status=1;
+	}
+	else status=2;
+	if (status) cJSON_Delete(value);
+	cJSON_Free(seg);
+	return status;
+}
+
+/* Put value in place of the item at pointer, which must exist. Takes value in all cases. */
+static int replace_at(cJSON *root,const char *pointer,cJSON *value)
+{
+	cJSON *parent;char *seg;int i=-1,status=2;
+	if (!value) return 1;
+	if (!*pointer) {swap_contents(root,value);cJSON_Delete(value);return 0;}
+	if ((parent=walk_parent(root,pointer,&seg)))
+	{
+		if ((parent->type&255)==cJSON_Array)		{i=array_index(seg);if (i>=cJSON_GetArraySize(parent)) i=-1;}
+		else if ((parent->type&255)==cJSON_Object)	{i=member_index(parent,seg);if (i>=0 && !set_name(value,seg)) i=-1,status=1;}
+		if (i>=0) status=!cJSON_ReplaceItemInArray(parent,i,value);
+	}
+	if (status) cJSON_Delete(value);
+	cJSON_Free(seg);
+	return status;
+}
+
+/* Take the item at pointer out of its parent. */
+static cJSON *detach_at(cJSON *root,const char *pointer)
+{
+	cJSON *parent,*item=0;char *seg;int i=-1;
+	if ((parent=walk_parent(root,pointer,&seg)))
+	{
+		if ((parent->type&255)==cJSON_Array)		i=array_index(seg);
+		else if ((parent->type&255)==cJSON_Object)	i=member_index(parent,seg);
+		if (i>=0) item=cJSON_DetachItemFromArray(parent,i);
+	}
+	cJSON_Free(seg);
+	return item;
+}
+
+/* Carry out a single JSON Patch operation. */
+static int apply_op(cJSON *root,cJSON *op)
+{
+	cJSON *name=member(op,"op"),*path=member(op,"path"),*value=member(op,"value"),*from=member(op,"from"),*item;
+	const char *p;
+	if (!name || (name->type&255)!=cJSON_String || !path || (path->type&255)!=cJSON_String) return 1;
+	p=path->valuestring;
+
+	if (!strcmp(name->valuestring,"test"))
+	{
+		if (!value) return 1;
+		return cJSON_Equal(find(root,p),value,cJSON_HashUnordered)?0:3;
+	}
+	if (!strcmp(name->valuestring,"remove"))
+	{
+		if (!(item=detach_at(root,p))) return 2;
+		cJSON_Delete(item);return 0;
+	}
+	if (!strcmp(name->valuestring,"replace"))
+	{
+		if (!value) return 1;
+		return replace_at(root,p,cJSON_Duplicate(value,1));
+	}
+	if (!strcmp(name->valuestring,"add"))
+	{
+		if (!value) return 1;
+		return insert_at(root,p,cJSON_Duplicate(value,1));
+	}
+	if (!from || (from->type&255)!=cJSON_String) return 1;
+	if (!strcmp(name->valuestring,"move"))
+	{
+		size_t len=strlen(from->valuestring);
+		if (!strncmp(p,from->valuestring,len) && p[len]=='/') return 1;	/* can't move an item into itself. */
+		if (!(item=detach_at(root,from->valuestring))) return 2;
+		return insert_at(root,p,item);
+	}
+	if (!strcmp(name->valuestring,"copy"))
+	{
+		if (!(item=find(root,from->valuestring))) return 2;
+		return insert_at(root,p,cJSON_Duplicate(item,1));
+	}
+	return 1;	/* unknown op. */
+}
+
+/* Patches are applied to a shared copy of doc, which only takes the place of the original once every op has succeeded. */
+int cJSON_ApplyPatch(cJSON *doc,cJSON *patch)
+{
+	cJSON *work,*op;int status=0;
+	if (!doc || !patch || (patch->type&255)!=cJSON_Array || cJSON_IsShared(doc)) return 1;
+	if (!(work=cJSON_DuplicateShared(doc))) return 1;
+	for (op=patch->child;op && !status;op=op->next) status=apply_op(work,op);
+	if (!status) swap_contents(doc,work);
+	cJSON_Delete(work);
+	return status;
+}
+
+/* Index of an object's members by name, used to pair up the members of two objects.
+Small objects are just scanned; larger ones get an open addressing hash table. */
+typedef struct {cJSON **items;unsigned *hashes;char *matched;int *slots;unsigned mask;int count;} name_table;
+
+static int table_build(name_table *t,cJSON *object)
+{
+	cJSON *c;int i;unsigned s;
+	memset(t,0,sizeof(*t));
+	for (c=object->child;c;c=c->next) t->count++;
+	if (!t->count) return 1;
+	t->items=(cJSON**)cJSON_Malloc(t->count*sizeof(cJSON*));
+	t->hashes=(unsigned*)cJSON_Malloc(t->count*sizeof(unsigned));
+	t->matched=(char*)cJSON_Malloc(t->count);
+	if (!t->items || !t->hashes || !t->matched) return 0;
+	memset(t->matched,0,t->count);
+	for (i=0,c=object->child;c;c=c->next,i++) t->items[i]=c,t->hashes[i]=name_hash(c->string);
+	if (t->count<=8) return 1;
+	for (t->mask=15;t->mask<(unsigned)t->count*2;t->mask=t->mask*2+1);
+	if (!(t->slots=(int*)cJSON_Malloc((t->mask+1)*sizeof(int)))) return 0;
+	for (s=0;s<=t->mask;s++) t->slots[s]=-1;
+	for (i=0;i<t->count;i++)
+	{
+		for (s=t->hashes[i]&t->mask;t->slots[s]>=0;s=(s+1)&t->mask);
+		t->slots[s]=i;
+	}
+	return 1;
+}
+
+/* Find the first member called name that has not been matched yet, and mark it matched. */
+static cJSON *table_match(name_table *t,const char *name)
+{
+	unsigned h=name_hash(name),s;int i;
+	if (!t->slots)
+	{
+		for (i=0;i<t->count;i++) if (!t->matched[i] && t->hashes[i]==h && name_equal(t->items[i]->string,name)) {t->matched[i]=1;return t->items[i];}
+		return 0;
+	}
+	/* Members were inserted in order, so probing finds duplicate names in order too. */
+	for (s=h&t->mask;(i=t->slots[s])>=0;s=(s+1)&t->mask)
+		if (!t->matched[i] && t->hashes[i]==h && name_equal(t->items[i]->string,name)) {t->matched[i]=1;return t->items[i];}
+	return 0;
+}
+
+static void table_free(name_table *t)	{cJSON_Free(t->items);cJSON_Free(t->hashes);cJSON_Free(t->matched);cJSON_Free(t->slots);}
+
+/* State for cJSON_Diff: the patch being built, and the pointer to where we are. */
+typedef struct {cJSON *patches;char *path;size_t len,cap;int fail;} diff_state;
+
+/* Append "/segment" to the current pointer, escaping ~ and /. Returns the old length to restore with path_pop. */
+static size_t path_push(diff_state *d,const char *seg)
+{
+	size_t old=d->len,need=d->len+2*strlen(seg)+2;
+	if (need>d->cap)
+	{
+		char *grown=(char*)cJSON_Malloc(need*2);
+		if (!grown) {d->fail=1;return old;}
+		if (d->path) {memcpy(grown,d->path,d->len+1);cJSON_Free(d->path);}
+		d->path=grown;d->cap=need*2;
+	}
+	d->path[d->len++]='/';
+	for (;*seg;seg++)
+	{
+		if (*seg=='~')		d->path[d->len++]='~',d->path[d->len++]='0';
+		else if (*seg=='/')	d->path[d->len++]='~',d->path[d->len++]='1';
+		else				d->path[d->len++]=*seg;
+	}
+	d->path[d->len]=0;
+	return old;
+}
+static size_t path_push_index(diff_state *d,int i)	{char num[16];sprintf(num,"%d",i);return path_push(d,num);}
+static void path_pop(diff_state *d,size_t old)		{d->len=old;if (d->path) d->path[old]=0;}
+
+static void emit(diff_state *d,const char *op,cJSON *value)
+{
+	cJSON *patch;
+	if (d->fail) {cJSON_Delete(value);return;}
+	if (!(patch=cJSON_CreateObject())) {d->fail=1;cJSON_Delete(value);return;}
+	cJSON_AddStringToObject(patch,"op",op);
+	cJSON_AddStringToObject(patch,"path",d->path?d->path:"");
+	if (value) cJSON_AddItemToObject(patch,"value",value);
+	if (cJSON_GetArraySize(patch)!=(value?3:2)) d->fail=1;
+	cJSON_AddItemToArray(d->patches,patch);
+}
+static void emit_value(diff_state *d,const char *op,cJSON *value)	{cJSON *v=cJSON_Duplicate(value,1);if (!v) d->fail=1;else emit(d,op,v);}
+static void emit_number(diff_state *d,const char *op,double number)	{cJSON *v=cJSON_CreateNumber(number);if (!v) d->fail=1;else emit(d,op,v);}
+
+static void diff_items(diff_state *d,cJSON *from,cJSON *to);
+
+/* Is item the number d? */
+static int is_number(cJSON *item,double d)	{return (item->type&255)==cJSON_Number && item->valuedouble==d;}
+/* Are element i of from and element j of to alike? Each is read from the numbers of a packed array (na, nb) or else
+is the item a, b. Cached hashes rule most unlike pairs out without walking them. */
+static int same_element(const double *na,cJSON *a,int i,const double *nb,cJSON *b,int j)
+{
+	if (na && nb)	return na[i]==nb[j];
+	if (na)			return is_number(b,na[i]);
+	if (nb)			return is_number(a,nb[j]);
+	return a==b || (cJSON_Hash(a,cJSON_HashCache|cJSON_HashUnordered)==cJSON_Hash(b,cJSON_HashCache|cJSON_HashUnordered) && cJSON_Equal(a,b,cJSON_HashUnordered));
+}
+
+static void diff_arrays(diff_state *d,cJSON *from,cJSON *to)
+{
+	const double *na=cJSON_GetDoubleArrayData(from),*nb=cJSON_GetDoubleArrayData(to);	/* a packed side is read in place rather than unpacked. */
+	cJSON *a=from->child,*b=to->child,*ta,*tb;int i,j,n=cJSON_GetArraySize(from),m=cJSON_GetArraySize(to),size=m;size_t old;
+	/* Skip what the two start and end with alike, so an insert or a removal anywhere is one op. */
+	for (i=0;i<n && i<m && same_element(na,a,i,nb,b,i);i++) {if (!na) a=a->next; if (!nb) b=b->next;}
+	for (ta=a;ta && ta->next;ta=ta->next);
+	for (tb=b;tb && tb->next;tb=tb->next);
+	while (n>i && m>i && same_element(na,ta,n-1,nb,tb,m-1)) {n--,m--;if (!na) ta=ta->prev; if (!nb) tb=tb->prev;}
+	/* Where they differ, pair items up by position... */
+	for (j=i;j<n && j<m && !d->fail;j++)
+	{
+		old=path_push_index(d,j);
+		if (na && nb)	{if (na[j]!=nb[j]) emit_number(d,"replace",nb[j]);}
+		else if (na)	{if (!is_number(b,na[j])) emit_value(d,"replace",b);}
+		else if (nb)	{if (!is_number(a,nb[j])) emit_number(d,"replace",nb[j]);}
+		else			diff_items(d,a,b);
+		path_pop(d,old);
+		if (!na) a=a->next;
+		if (!nb) b=b->next;
+	}
+	/* ...then remove the surplus from the back, so the indices of the ones before stay put, or add what is missing. */
+	for (i=n;i-->j && !d->fail;) {old=path_push_index(d,i);emit(d,"remove",0);path_pop(d,old);}
+	for (i=j;i<m && !d->fail;i++)
+	{
+		old=(m==size)?path_push(d,"-"):path_push_index(d,i);
+		if (nb) emit_number(d,"add",nb[i]); else emit_value(d,"add",b),b=b->next;
+		path_pop(d,old);
+	}
+}
+
+static void diff_objects(diff_state *d,cJSON *from,cJSON *to)
+{
+	name_table t;cJSON *a,*b;int i;size_t old;
+	if (!table_build(&t,to)) {table_free(&t);d->fail=1;return;}
+	for (a=from->child;a && !d->fail;a=a->next)
+	{
+		old=path_push(d,a->string?a->string:"");
+		if ((b=table_match(&t,a->string))) diff_items(d,a,b);
+		else emit(d,"remove",0);
+		path_pop(d,old);
+	}
+	for (i=0;i<t.count && !d->fail;i++) if (!t.matched[i])
+	{
+		old=path_push(d,t.items[i]->string?t.items[i]->string:"");
+		emit_value(d,"add",t.items[i]);
+		path_pop(d,old);
+	}
+	table_free(&t);
+}
+
+static void diff_items(diff_state *d,cJSON *from,cJSON *to)
+{
+	int type=from->type&255;
+	if (from==to) return;
+	if (type!=(to->type&255))	{emit_value(d,"replace",to);return;}
+	if (type==cJSON_Array || type==cJSON_Object)
+	{
+		if (from->child==to->child && cJSON_GetDoubleArrayData(from)==cJSON_GetDoubleArrayData(to)) return;	/* the same, or a shared, chain of children. */
+		/* Equal subtrees need no ops. The cached hashes make ruling this out cheap at every level. */
+		if (cJSON_Hash(from,cJSON_HashCache|cJSON_HashUnordered)==cJSON_Hash(to,cJSON_HashCache|cJSON_HashUnordered) && cJSON_Equal(from,to,cJSON_HashUnordered)) return;
+		if (type==cJSON_Array) diff_arrays(d,from,to); else diff_objects(d,from,to);
+	}
+	else if (!cJSON_Equal(from,to,0)) emit_value(d,"replace",to);
+}
+
+cJSON *cJSON_Diff(cJSON *from,cJSON *to)
+{
+	diff_state d;
+	if (!from || !to) return 0;
+	memset(&d,0,sizeof(d));
+	if (!(d.patches=cJSON_CreateArray())) return 0;
+	diff_items(&d,from,to);
+	cJSON_Free(d.path);
+	if (d.fail) {cJSON_Delete(d.patches);return 0;}
+	return d.patches;
+}
+
+/* Merge patches. A new member's value is the patch with any null members dropped. */
+static cJSON *merge_value(cJSON *patch)
+{
+	cJSON *out,*c,*v;
+	if ((patch->type&255)!=cJSON_Object) return cJSON_Duplicate(patch,1);
+	if (!(out=cJSON_CreateObject())) return 0;
+	for (c=patch->child;c;c=c->next)
+	{
+		if ((c->type&255)==cJSON_NULL) continue;
+		if (!(v=merge_value(c))) {cJSON_Delete(out);return 0;}
+		cJSON_AddItemToObject(out,c->string,v);
+	}
+	return out;
+}
+
+static int merge(cJSON *target,cJSON *patch)
+{
+	cJSON *c,*v;int i;
+	if ((patch->type&255)!=cJSON_Object || (target->type&255)!=cJSON_Object)
+	{
+		if (!(v=merge_value(patch))) return 1;
+		swap_contents(target,v);cJSON_Delete(v);
+		return 0;
+	}
+	for (c=patch->child;c;c=c->next)
+	{
+		i=member_index(target,c->string);
+		if ((c->type&255)==cJSON_NULL)	{if (i>=0) cJSON_DeleteItemFromArray(target,i);}
+		else if (i>=0)					{if (!(v=cJSON_GetArrayItemForWrite(target,i)) || merge(v,c)) return 1;}
+		else if ((v=merge_value(c)))	cJSON_AddItemToObject(target,c->string,v);
+		else return 1;
+	}
+	return 0;
+}
+
+int cJSON_ApplyMergePatch(cJSON *doc,cJSON *patch)
+{
+	cJSON *work;int status;
+	if (!doc || !patch || cJSON_IsShared(doc) || !(work=cJSON_DuplicateShared(doc))) return 1;
+	if (!(status=merge(work,patch))) swap_contents(doc,work);
+	cJSON_Delete(work);
+	return status;
+}
+
+cJSON *cJSON_MergeDiff(cJSON *from,cJSON *to)
+{
+	name_table t;cJSON *patch,*a,*b,*v;int i;
+	if (!from || !to) return 0;
+	if ((from->type&255)!=cJSON_Object || (to->type&255)!=cJSON_Object) return cJSON_Duplicate(to,1);
+	if (!(patch=cJSON_CreateObject())) return 0;
+	if (from->child==to->child) return patch;
+	if (!table_build(&t,to)) {table_free(&t);cJSON_Delete(patch);return 0;}
+	for (a=from->child;a;a=a->next)
+	{
+		if (!(b=table_match(&t,a->string)))	v=cJSON_CreateNull();
+		else if (cJSON_Equal(a,b,cJSON_HashUnordered)) continue;
+		else								v=cJSON_MergeDiff(a,b);
+		if (!v) {table_free(&t);cJSON_Delete(patch);return 0;}
+		cJSON_AddItemToObject(patch,a->string,v);
+	}
+	for (i=0;i<t.count;i++) if (!t.matched[i])
+	{
+		if (!(v=cJSON_Duplicate(t.items[i],1))) {table_free(&t);cJSON_Delete(patch);return 0;}
+		cJSON_AddItemToObject(patch,t.items[i]->string,v);
+	}
+	table_free(&t);
+	return patch;
+}
+
+/* Compiled paths. Each segment is decoded once, with its length, hash and array index worked out up front. */
+typedef struct {const char *name;size_t len;unsigned hash;int index,wildcard;} path_segment;
+struct cJSON_Path {int count;path_segment *segs;};
+
+cJSON_Path *cJSON_CompilePath(const char *pointer)
+{
+	cJSON_Path *path;const char *ptr,*end;char *names;int n=0,len;size_t size;
+	if (!pointer || (*pointer && *pointer!='/')) return 0;
+	for (ptr=pointer;*ptr;ptr++) if (*ptr=='/') n++;
+	end=ptr;
+	/* One block: the path, its segments, then their decoded names. */
+	size=sizeof(cJSON_Path)+n*sizeof(path_segment);
+	if (!(path=(cJSON_Path*)cJSON_Malloc(size+(end-pointer)+n))) return 0;
+	path->segs=(path_segment*)(path+1);names=(char*)path+size;
+	for (path->count=0,ptr=pointer;ptr<end;path->count++)
+	{
+		path_segment *seg=path->segs+path->count;
+		if ((len=decode_into(ptr+1,end,names,&ptr))<0) {cJSON_Free(path);return 0;}
+		seg->name=names;seg->len=len;seg->hash=name_hash(names);seg->index=array_index(names);
+		seg->wildcard=!strcmp(names,"*");
+		names+=len+1;
+	}
+	return path;
+}
+void cJSON_DeletePath(cJSON_Path *path)	{cJSON_Free(path);}
+
+/* Does the member name match seg? Most misses are settled by the first byte. Otherwise the name is hashed, stopping once
+it runs longer than seg, and only a name with seg's precomputed length and hash is compared byte by byte. */
+static int segment_is(const path_segment *seg,const char *name)
+{
+	unsigned h=2166136261u;size_t n;
+	if (!name || *name!=*seg->name) return 0;
+	for (n=0;name[n] && n<=seg->len;n++) h=(h^(unsigned char)name[n])*16777619u;
+	return n==seg->len && h==seg->hash && !memcmp(name,seg->name,n);
+}
+
+/* Match segs[0..count) below item, storing up to max results from found on. Returns the new number found. */
+static int query(cJSON *item,const path_segment *seg,int count,cJSON **results,int max,int found)
+{
+	cJSON *c;int i;
+	if (!count) {if (found<max) results[found]=item;return found+1;}
+	if ((item->type&255)==cJSON_Object)
+	{
+		for (c=item->child;c;c=c->next) if (seg->wildcard || segment_is(seg,c->string))
+		{
+			found=query(c,seg+1,count-1,results,max,found);
+			if (!seg->wildcard) break;	/* the first member of that name, as for cJSON_GetPointer */
+		}
+	}
+	else if ((item->type&255)==cJSON_Array && !(item->type&cJSON_IsPacked))
+	{
+		if (seg->wildcard) for (c=item->child;c;c=c->next) found=query(c,seg+1,count-1,results,max,found);
+		else if (seg->index>=0)
+		{
+			for (c=item->child,i=seg->index;c && i>0;i--) c=c->next;
+			if (c) found=query(c,seg+1,count-1,results,max,found);
+		}
+	}
+	return found;
+}
+
+int cJSON_QueryCompiled(cJSON *doc,const cJSON_Path *path,cJSON **results,int max)	{return (doc && path)?query(doc,path->segs,path->count,results,max,0):0;}
+
+/* Batch queries. active[0..n) holds the paths still looking for a match under item, all of which have matched depth
+segments so far. Each child is handed the paths that match it, gathered at the front of active. */
+static void query_batch(cJSON *item,cJSON_Path *const *paths,int *active,int n,int depth,cJSON **results)
+{
+	cJSON *c;int i,k,t,index,object,objects=(item->type&255)==cJSON_Object;unsigned h=0;const path_segment *seg;
+	/* Paths that end here, and paths matched elsewhere already, are done. */
+	for (i=0;i<n;)
+	{
+		if (results[active[i]]) {t=active[i];active[i]=active[--n];active[n]=t;}
+		else if (paths[active[i]]->count==depth) {results[active[i]]=item;t=active[i];active[i]=active[--n];active[n]=t;}
+		else i++;
+	}
+	if (!objects && ((item->type&255)!=cJSON_Array || (item->type&cJSON_IsPacked))) return;
+	for (c=item->child,index=0;c && n;c=c->next,index++)
+	{
+		object=objects && c->string;
+		if (object) h=name_hash(c->string);
+		for (i=k=0;i<n;i++)
+		{
+			seg=paths[active[i]]->segs+depth;
+			if (seg->wildcard || (object?(seg->hash==h && seg->len==strlen(c->string) && !strcmp(seg->name,c->string)):(!objects && seg->index==index)))
+				{t=active[i];active[i]=active[k];active[k++]=t;}
+		}
+		if (!k) continue;
+		query_batch(c,paths,active,k,depth+1,results);
+		/* A named segment only matches the first member of that name; wildcards go on to the next child. */
+		for (i=0;i<k;)
+		{
+			if (paths[active[i]]->segs[depth].wildcard) i++;
+			else {t=active[i];active[i]=active[--k];active[k]=t;t=active[k];active[k]=active[--n];active[n]=t;}
+		}
+	}
+}
+
+int cJSON_QueryBatch(cJSON *doc,cJSON_Path *const *paths,int count,cJSON **results)
+{
+	int *active,i,n=0;
+	for (i=0;i<count;i++) results[i]=0;
+	if (!doc || count<=0) return 0;
+	if (!(active=(int*)cJSON_Malloc(count*sizeof(int)))) return -1;
+	for (i=0;i<count;i++) if (paths[i]) active[n++]=i;
+	query_batch(doc,paths,active,n,0,results);
+	cJSON_Free(active);
+	for (i=n=0;i<count;i++) if (results[i]) n++;
+	return n;
+}
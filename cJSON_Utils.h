@@ -0,0 +1,71 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef cJSON_Utils__h
+#define cJSON_Utils__h
+
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Look up an item by RFC6901 JSON Pointer ("/a/b/0"). Member names are case sensitive here. Returns 0 if there is no such item.
+This only reads, like cJSON_GetArrayItem: to change what it finds in a shared tree, walk there with the ForWrite calls instead. */
+extern cJSON *cJSON_GetPointer(cJSON *object,const char *pointer);
+
+/* Compiled paths, for pointers that are looked up again and again. CompilePath takes an RFC6901 pointer in which a
+segment of just * matches every member or element, so a member really called "*" can only be reached by GetPointer.
+Returns 0 for a malformed pointer or on memory fail. */
+typedef struct cJSON_Path cJSON_Path;
+extern cJSON_Path *cJSON_CompilePath(const char *pointer);
+extern void cJSON_DeletePath(cJSON_Path *path);
+/* Store up to max of the items path matches in results, in document order, and return how many it matches in all.
+This only reads the tree - it allocates nothing and does not copy shared children, so don't change a shared tree through
+what it finds - and it does not look inside packed arrays (see cJSON_GetDoubleArrayData). */
+extern int cJSON_QueryCompiled(cJSON *doc,const cJSON_Path *path,cJSON **results,int max);
+/* Evaluate many paths in one walk of the tree: results[i] gets the first item paths[i] matches, or 0.
+Returns how many paths matched, or -1 on memory fail. */
+extern int cJSON_QueryBatch(cJSON *doc,cJSON_Path *const *paths,int count,cJSON **results);
+
+/* RFC6902 JSON Patch. Diff returns an array of operations that turns from into to; Delete it when finished.
+Objects' members are matched up by name through a hash table, and children that from and to share (see
+cJSON_DuplicateShared) are skipped without being walked, so the work follows the size of the change. Arrays are matched
+up past the elements they start and end with alike, so an insert or a removal is one op.
+Diff keeps cJSON_HashCache hashes in the arrays and objects of both from and to: it writes to them, so no other thread
+may use either tree while it runs. */
+extern cJSON *cJSON_Diff(cJSON *from,cJSON *to);
+/* Apply a JSON Patch to doc in place. Returns 0 on success. If the patch is malformed, a path does not resolve, a test
+fails or doc was reached through shared children (see cJSON_IsShared), it returns non-zero and doc is left exactly as it was. */
+extern int cJSON_ApplyPatch(cJSON *doc,cJSON *patch);
+
+/* RFC7386 JSON Merge Patch. MergeDiff returns a patch turning from into to (a merge patch cannot set a member to null). */
+extern cJSON *cJSON_MergeDiff(cJSON *from,cJSON *to);
+/* Apply a merge patch to doc in place. Returns 0 on success, non-zero on memory fail or if cJSON_IsShared(doc). */
+extern int cJSON_ApplyMergePatch(cJSON *doc,cJSON *patch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,7 +22,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "cJSON.h"
+#include "cJSON_Utils.h"
 
 /* Parse text to JSON, then render back to text, and print! */
 void doit(char *text)
@@ -127,6 +129,342 @@ void create_objects()
 
 }
 
+/* Checks of the extensions. Only failures are printed; main returns non-zero if there were any. */
+static int failures;
+static void check(int ok,const char *what)	{if (!ok) {failures++;printf("FAILED: %s\n",what);}}
+
+/* Does item print (unformatted) as text? */
+static int prints_as(cJSON *item,const char *text)	{char *out=item?cJSON_PrintUnformatted(item):0;int ok=out && !strcmp(out,text);free(out);return ok;}
+
+/* Copy-on-write clones: each side can be changed or freed without the other noticing. */
+void shared_checks()
+{
+	const char *text="{\"a\":{\"b\":[1,2]},\"c\":{\"d\":true}}";
+	cJSON *root,*clone,*n;
+
+	root=cJSON_Parse(text);clone=cJSON_DuplicateShared(root);
+	cJSON_GetObjectItem(cJSON_GetObjectItem(clone,"a"),"b");
+	check(clone->child==root->child,"shared: reading copies nothing");
+	cJSON_Delete(root);
+	check(prints_as(clone,text),"shared: clone outlives the original");
+	cJSON_Delete(clone);
+
+	root=cJSON_Parse(text);clone=cJSON_DuplicateShared(root);
+	cJSON_Delete(clone);
+	check(prints_as(root,text),"shared: original outlives the clone");
+
+	clone=cJSON_DuplicateShared(root);
+	cJSON_ReplaceItemInArray(cJSON_GetObjectItemForWrite(cJSON_GetObjectItemForWrite(clone,"a"),"b"),0,cJSON_CreateNumber(7));
+	check(prints_as(clone,"{\"a\":{\"b\":[7,2]},\"c\":{\"d\":true}}") && prints_as(root,text),"shared: replace in the clone");
+	check(cJSON_GetObjectItem(clone,"c")->child==cJSON_GetObjectItem(root,"c")->child,"shared: untouched branches stay shared");
+	cJSON_Delete(cJSON_DetachItemFromObject(cJSON_GetObjectItemForWrite(root,"c"),"d"));
+	check(prints_as(root,"{\"a\":{\"b\":[1,2]},\"c\":{}}") && prints_as(clone,"{\"a\":{\"b\":[7,2]},\"c\":{\"d\":true}}"),"shared: detach in the original");
+	cJSON_ReplaceItemInObject(clone,"a",cJSON_CreateNull());
+	cJSON_Delete(cJSON_DetachItemFromArray(cJSON_GetObjectItemForWrite(cJSON_GetObjectItemForWrite(root,"a"),"b"),1));
+	check(prints_as(root,"{\"a\":{\"b\":[1]},\"c\":{}}") && prints_as(clone,"{\"a\":null,\"c\":{\"d\":true}}"),"shared: replace in the clone, detach in the original");
+	cJSON_Delete(root);
+	check(prints_as(clone,"{\"a\":null,\"c\":{\"d\":true}}"),"shared: changed clone outlives the original");
+	cJSON_Delete(clone);
+
+	/* Reached with the read-only calls, a shared array/object refuses changes, as one whose owner is not known does. */
+	root=cJSON_Parse(text);clone=cJSON_DuplicateShared(root);
+	n=cJSON_CreateNull();
+	check(!cJSON_AddItemToObject(cJSON_GetObjectItem(clone,"a"),"x",n) && prints_as(root,text) && prints_as(clone,text),"shared: a change through Get is refused");
+	check(cJSON_IsShared(cJSON_GetObjectItem(root,"a")) && !cJSON_IsShared(root) && !cJSON_GetObjectItemForWrite(cJSON_GetObjectItem(clone,"a"),"b"),"shared: IsShared, and ForWrite below it fails");
+	cJSON_Delete(root);
+	check(!cJSON_AddItemToObject(cJSON_GetObjectItem(clone,"c"),"x",n),"shared: refused where the owner that let go is not known");
+	check(cJSON_AddItemToObject(cJSON_GetObjectItemForWrite(clone,"a"),"x",n),"shared: the same change through ForWrite");
+	cJSON_AddItemToObject(cJSON_GetObjectItem(clone,"c"),"e",cJSON_CreateNull());
+	check(prints_as(clone,"{\"a\":{\"b\":[1,2],\"x\":null},\"c\":{\"d\":true,\"e\":null}}"),"shared: change after the original is gone");
+	root=cJSON_DuplicateShared(clone);
+	cJSON_GetObjectItemForWrite(clone,"a");
+	cJSON_Delete(clone);
+	cJSON_AddItemToObject(cJSON_GetObjectItemForWrite(root,"a"),"f",cJSON_CreateFalse());
+	check(prints_as(root,"{\"a\":{\"b\":[1,2],\"x\":null,\"f\":false},\"c\":{\"d\":true,\"e\":null}}"),"shared: change after the other owner copied and went");
+	clone=cJSON_DuplicateShared(root);
+	n=cJSON_CreateNull();
+	check(!cJSON_AddItemToArray(cJSON_GetObjectItem(cJSON_GetObjectItem(clone,"a"),"b"),n) && cJSON_ApplyMergePatch(cJSON_GetObjectItem(root,"c"),n),"shared: refused two levels below a shared chain");
+	cJSON_Delete(n);cJSON_Delete(clone);
+	cJSON_Delete(root);
+}
+
+/* cJSON_Hash and cJSON_Equal: member order, exact numbers, packed arrays and the hash cache. */
+void hash_checks()
+{
+	cJSON *a=cJSON_Parse("{\"x\":1,\"y\":[1,2.5,-0.0]}"),*b=cJSON_Parse("{\"y\":[1,2.5,0],\"x\":1}");
+	cJSON *packed=cJSON_ParseWithFlags("[[1,2,3],{\"n\":[4,5]}]",0,cJSON_ParsePackNumbers),*plain=cJSON_Parse("[[1,2,3],{\"n\":[4,5]}]");
+	unsigned before;
+
+	check(cJSON_Equal(a,b,cJSON_HashUnordered) && !cJSON_Equal(a,b,0),"hash: member order only matters when ordered");
+	check(cJSON_Hash(a,cJSON_HashUnordered)==cJSON_Hash(b,cJSON_HashUnordered),"hash: unordered hashes agree");
+	check(!cJSON_Equal(a,b,cJSON_HashUnordered|cJSON_HashExact),"hash: exact tells 0 from -0");
+
+	check((cJSON_GetArrayItem(packed,0)->type&cJSON_IsPacked) && !(cJSON_GetArrayItem(plain,0)->type&cJSON_IsPacked),"hash: numbers packed on request");
+	check(cJSON_Equal(packed,plain,cJSON_HashExact) && cJSON_Hash(packed,cJSON_HashExact)==cJSON_Hash(plain,cJSON_HashExact),"hash: packed and unpacked arrays agree");
+
+	before=cJSON_Hash(a,cJSON_HashCache);
+	cJSON_ReplaceItemInArray(cJSON_GetObjectItemForWrite(a,"y"),2,cJSON_CreateNumber(3));
+	check(cJSON_Hash(a,cJSON_HashCache)!=before && cJSON_Hash(a,cJSON_HashCache)==cJSON_Hash(a,0),"hash: a change drops the cached hashes above it");
+	cJSON_ReplaceItemInArray(cJSON_GetObjectItemForWrite(a,"y"),2,cJSON_CreateNumber(-0.0));
+	check(cJSON_Hash(a,cJSON_HashCache)==before,"hash: changing it back restores the hash");
+
+	cJSON_Delete(a);cJSON_Delete(b);cJSON_Delete(packed);cJSON_Delete(plain);
+}
+
+/* Does applying patch (as JSON text) to doc succeed and leave want? For a patch that should fail, want is doc itself. */
+static int patches_to(const char *doc,const char *patch,const char *want,int merge)
+{
+	cJSON *d=cJSON_Parse(doc),*p=cJSON_Parse(patch),*w=cJSON_Parse(want);
+	int status=merge?cJSON_ApplyMergePatch(d,p):cJSON_ApplyPatch(d,p);
+	int ok=(strcmp(doc,want)?!status:status!=0) && cJSON_Equal(d,w,cJSON_HashUnordered);
+	cJSON_Delete(d);cJSON_Delete(p);cJSON_Delete(w);
+	return ok;
+}
+
+/* Does the diff from one text to the other turn the first into the second, in ops ops (if ops>=0)? */
+static int diffs_to(const char *from,const char *to,int ops,int merge)
+{
+	cJSON *f=cJSON_Parse(from),*t=cJSON_Parse(to),*p=merge?cJSON_MergeDiff(f,t):cJSON_Diff(f,t);
+	int ok=p && (ops<0 || cJSON_GetArraySize(p)==ops) && !(merge?cJSON_ApplyMergePatch(f,p):cJSON_ApplyPatch(f,p)) && cJSON_Equal(f,t,cJSON_HashUnordered);
+	cJSON_Delete(f);cJSON_Delete(t);cJSON_Delete(p);
+	return ok;
+}
+
+/* RFC6902 JSON Patch and RFC7386 Merge Patch. */
+void patch_checks()
+{
+	const char *doc="{\"a\":{\"b\":1},\"c\":[1,2]}";
+	const char *from="{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"},\"same\":{\"deep\":[1,2,{\"x\":1}]}}";
+	const char *to="{\"same\":{\"deep\":[1,2,{\"x\":1}]},\"a\":2,\"b\":[1,3],\"c\":{\"d\":\"x\",\"e\":true},\"f\":[]}";
+
+	check(diffs_to(from,to,-1,0) && diffs_to(to,from,-1,0),"patch: diff and apply round trip");
+	check(diffs_to("[1,[2,3],{\"k\":\"v\"}]","[1,[2,3,4],{\"k\":\"w\"},5]",3,0),"patch: array diff");
+	check(diffs_to("[1,2,3,4,5,6,7,8]","[0,1,2,3,4,5,6,7,8]",1,0) && diffs_to("[1,2,3,{\"x\":4},5,6]","[1,2,{\"x\":4},5,6]",1,0) && diffs_to("[1,2,3]","[1,[9],3,4]",2,0),"patch: arrays skip what they start and end with");
+	check(diffs_to(from,"{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"},\"same\":{\"deep\":[1,2,{\"x\":2}]}}",1,0),"patch: only the changed leaf is patched");
+	check(diffs_to(from,to,-1,1) && diffs_to(to,from,-1,1),"patch: merge diff and apply round trip");
+
+	check(patches_to(doc,"[{\"op\":\"move\",\"from\":\"/a/b\",\"path\":\"/c/0\"},{\"op\":\"copy\",\"from\":\"/c\",\"path\":\"/d\"},"
+		"{\"op\":\"test\",\"path\":\"/d/0\",\"value\":1},{\"op\":\"test\",\"path\":\"/a\",\"value\":{}}]","{\"a\":{},\"c\":[1,1,2],\"d\":[1,1,2]}",0),"patch: move, copy and test");
+	check(patches_to(doc,"[{\"op\":\"add\",\"path\":\"/x~1y~0\",\"value\":0},{\"op\":\"replace\",\"path\":\"\",\"value\":{\"x/y~\":0}}]","{\"x/y~\":0}",0),"patch: escaped names and the root");
+	check(patches_to(doc,"[{\"op\":\"add\",\"path\":\"/e\",\"value\":3},{\"op\":\"remove\",\"path\":\"/missing\"}]",doc,0),"patch: a failed op rolls back the ones before");
+	check(patches_to(doc,"[{\"op\":\"replace\",\"path\":\"/c/1\",\"value\":5},{\"op\":\"test\",\"path\":\"/c/1\",\"value\":2}]",doc,0),"patch: a failed test rolls back");
+	check(patches_to(doc,"[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b\"}]",doc,0),"patch: no moving an item into itself");
+
+	check(patches_to("{\"title\":\"Goodbye!\",\"author\":{\"givenName\":\"John\",\"familyName\":\"Doe\"},\"tags\":[\"example\",\"sample\"],\"content\":\"This will be unchanged\"}",
+		"{\"title\":\"Hello!\",\"phoneNumber\":\"+01-555-555-5555\",\"author\":{\"familyName\":null},\"tags\":[\"example\"]}",
+		"{\"title\":\"Hello!\",\"author\":{\"givenName\":\"John\"},\"tags\":[\"example\"],\"content\":\"This will be unchanged\",\"phoneNumber\":\"+01-555-555-5555\"}",1),"patch: the RFC7386 example");
+}
+
+/* Packed number arrays are opt-in, and only unpacked to be written. */
+void packed_checks()
+{
+	int numbers[3]={1,2,3};
+	cJSON *plain=cJSON_CreateIntArray(numbers,3),*packed=cJSON_CreatePackedIntArray(numbers,3),*parsed,*patch;
+
+	check(!(plain->type&cJSON_IsPacked) && (packed->type&cJSON_IsPacked) && cJSON_Equal(plain,packed,0),"packed: only on request");
+	check(!cJSON_GetArrayItem(packed,1) && (packed->type&cJSON_IsPacked) && cJSON_GetDoubleArrayData(packed)[1]==2,"packed: reading leaves it packed");
+	check((patch=cJSON_Diff(plain,packed)) && cJSON_GetArraySize(patch)==0 && (packed->type&cJSON_IsPacked),"packed: diffed in place");
+	cJSON_Delete(patch);
+	cJSON_ReplaceItemInArray(plain,2,cJSON_CreateString("x"));
+	check((patch=cJSON_Diff(packed,plain)) && cJSON_GetArraySize(patch)==1 && !cJSON_ApplyPatch(packed,patch) && cJSON_Equal(packed,plain,0),"packed: diffed against an ordinary array");
+	cJSON_Delete(patch);
+	check(cJSON_GetArrayItemForWrite(packed,1)->valuedouble==2 && !(packed->type&cJSON_IsPacked),"packed: unpacked for writing");
+
+	parsed=cJSON_ParseWithFlags("[1,2,\"x\",3,[4]]",0,cJSON_ParsePackNumbers);
+	check(parsed && !(parsed->type&cJSON_IsPacked) && prints_as(parsed,"[1,2,\"x\",3,[4]]") && cJSON_GetArrayItem(parsed,1)->parent==parsed,"packed: numbers before a non-number become items");
+	cJSON_Delete(parsed);
+	check(!cJSON_ParseWithFlags("[1,2 3]",0,cJSON_ParsePackNumbers) && !cJSON_ParseWithFlags("[1,2,]",0,cJSON_ParsePackNumbers),"packed: malformed arrays fail");
+	cJSON_Delete(cJSON_ParseWithFlags("[1]",0,cJSON_ParsePackNumbers));
+	parsed=cJSON_Parse("[1,2]");
+	check(!(parsed->type&cJSON_IsPacked),"packed: parse flags last one call");
+	cJSON_Delete(parsed);cJSON_Delete(plain);cJSON_Delete(packed);
+}
+
+/* Does the string in print as want with opts? */
+static int escapes_to(const char *in,int opts,const char *want)
+{
+	cJSON *item=cJSON_CreateString(in);char *out=cJSON_PrintWithOpts(item,opts);
+	int ok=out && !strcmp(out,want);
+	free(out);cJSON_Delete(item);
+	return ok;
+}
+
+/* String escaping, with and without cJSON_PrintASCII. */
+void escape_checks()
+{
+	check(escapes_to("a\n\x01\"\\/",0,"\"a\\n\\u0001\\\"\\\\/\""),"escape: control characters, quotes and backslashes");
+	check(escapes_to("\xC3\xA9",0,"\"\xC3\xA9\"") && escapes_to("\xC3\xA9",cJSON_PrintASCII,"\"\\u00e9\""),"escape: UTF-8 kept, or escaped for ASCII");
+	check(escapes_to("\xE2\x82\xAC\xF0\x9F\x98\x80",cJSON_PrintASCII,"\"\\u20ac\\ud83d\\ude00\""),"escape: three and four byte sequences");
+	check(escapes_to("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\xC3\xA9z",cJSON_PrintASCII,"\"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\\u00e9z\""),"escape: after a long clean run");
+	check(escapes_to("\xC0\xAF\xE0\x80\xAF",cJSON_PrintASCII,"\"\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd\""),"escape: overlong forms byte by byte");
+	check(escapes_to("\xED\xA0\x80",cJSON_PrintASCII,"\"\\ufffd\\ufffd\\ufffd\""),"escape: encoded surrogates byte by byte");
+	check(escapes_to("\xF8\x88\x80\x80\xFF",cJSON_PrintASCII,"\"\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd\""),"escape: invalid lead bytes byte by byte");
+	check(escapes_to("\xE2\x82",cJSON_PrintASCII,"\"\\ufffd\\ufffd\""),"escape: truncated sequences byte by byte");
+}
+
+/* Does a cached print of item give what an uncached one does, and want if given? */
+static int cached_ok(cJSON *item,const char *want)
+{
+	char *cached=cJSON_PrintWithOpts(item,cJSON_PrintCached),*plain=cJSON_PrintUnformatted(item);
+	int ok=cached && plain && !strcmp(cached,plain) && (!want || !strcmp(cached,want));
+	free(cached);free(plain);
+	return ok;
+}
+
+/* cJSON_PrintCached: a change anywhere drops the text of everything above it. */
+void cache_checks()
+{
+	cJSON *root=cJSON_Parse("{\"a\":{\"b\":[1,2]},\"c\":{}}"),*a,*n,*clone,*other=cJSON_CreateObject();
+	unsigned h;
+
+	check(cached_ok(root,"{\"a\":{\"b\":[1,2]},\"c\":{}}"),"cache: first print");
+	a=cJSON_GetObjectItem(root,"a");
+	check(cached_ok(a,"{\"b\":[1,2]}"),"cache: print of a member");
+	cJSON_AddItemToObject(a,"new",cJSON_CreateNumber(3));
+	check(cached_ok(root,"{\"a\":{\"b\":[1,2],\"new\":3},\"c\":{}}"),"cache: add below the root");
+	cJSON_ReplaceItemInArray(cJSON_GetObjectItem(a,"b"),0,cJSON_CreateNumber(9));
+	check(cached_ok(root,"{\"a\":{\"b\":[9,2],\"new\":3},\"c\":{}}"),"cache: replace two levels down");
+	cJSON_DeleteItemFromObject(root,"c");
+	cJSON_InsertItemInArray(cJSON_GetObjectItem(a,"b"),0,cJSON_CreateString("x"));
+	check(cached_ok(root,"{\"a\":{\"b\":[\"x\",9,2],\"new\":3}}"),"cache: delete and insert");
+	cJSON_Delete(cJSON_DetachItemFromArray(cJSON_GetObjectItem(a,"b"),0));
+
+	h=cJSON_Hash(root,cJSON_HashCache);
+	n=cJSON_GetArrayItem(cJSON_GetObjectItem(a,"b"),1);
+	n->valuedouble=5;n->valueint=5;cJSON_MarkDirty(n);
+	check(cached_ok(root,"{\"a\":{\"b\":[9,5],\"new\":3}}"),"cache: MarkDirty drops the text above");
+	check(cJSON_Hash(root,cJSON_HashCache)!=h && cJSON_Hash(root,cJSON_HashCache)==cJSON_Hash(root,0),"cache: MarkDirty drops the hashes above");
+
+	clone=cJSON_DuplicateShared(root);
+	check(cached_ok(clone,0),"cache: print of a clone");
+	cJSON_ReplaceItemInObject(cJSON_GetObjectItemForWrite(clone,"a"),"new",cJSON_CreateNull());
+	check(cached_ok(clone,"{\"a\":{\"b\":[9,5],\"new\":null}}") && cached_ok(root,"{\"a\":{\"b\":[9,5],\"new\":3}}"),"cache: a change in a clone");
+	cJSON_Delete(clone);
+
+	cJSON_AddItemToObject(other,"o",cJSON_CreateObject());
+	cJSON_AddItemReferenceToObject(a,"ref",other);
+	check(cached_ok(root,0),"cache: print with a reference");
+	cJSON_AddTrueToObject(cJSON_GetObjectItem(other,"o"),"t");
+	check(cached_ok(root,"{\"a\":{\"b\":[9,5],\"new\":3,\"ref\":{\"o\":{\"t\":true}}}}"),"cache: text above a reference is never kept");
+
+	cJSON_Delete(root);cJSON_Delete(other);
+}
+
+/* Struct binding. */
+typedef struct {char name[8];int x;} bound_point;
+typedef struct {int id;double score;int ok;char *title;char code[4];bound_point at;int ntags;char *tags[3];int npts;bound_point pts[2];} bound_record;
+static const cJSON_Field point_fields[]={cJSON_BindField(bound_point,name,cJSON_BindChars),cJSON_BindField(bound_point,x,cJSON_BindInt),cJSON_BindEnd};
+static const cJSON_Field record_fields[]={
+	cJSON_BindField(bound_record,id,cJSON_BindInt),cJSON_BindField(bound_record,score,cJSON_BindDouble),cJSON_BindField(bound_record,ok,cJSON_BindBool),
+	cJSON_BindField(bound_record,title,cJSON_BindString),cJSON_BindField(bound_record,code,cJSON_BindChars),cJSON_BindNested(bound_record,at,point_fields),
+	cJSON_BindList(bound_record,tags,cJSON_BindString,ntags,0),cJSON_BindList(bound_record,pts,cJSON_BindStruct,npts,point_fields),cJSON_BindEnd};
+
+/* Do the len bytes of text (all of it if len is 0) parse into a record, or fail to if !ok, and print back as what want parses to? */
+static int binds_to(cJSON_Schema *s,const char *text,size_t len,int ok,const char *want)
+{
+	bound_record r;char *out=0;cJSON *a=0,*b=0;int good;
+	memset(&r,0,sizeof(r));
+	if (!len) len=strlen(text);
+	good=(cJSON_ParseInto(s,text,len,&r)==0)==ok;
+	if (good && want) good=(out=cJSON_PrintFrom(s,&r)) && (a=cJSON_Parse(out)) && (b=cJSON_Parse(want)) && cJSON_Equal(a,b,0);
+	cJSON_FreeBound(s,&r);
+	free(out);cJSON_Delete(a);cJSON_Delete(b);
+	return good && !r.title && !r.ntags;
+}
+
+void bind_checks()
+{
+	const char *full="{\"id\":7,\"score\":2.5,\"ok\":true,\"title\":\"T \\\"q\\\"\",\"code\":\"ab\",\"at\":{\"name\":\"p\",\"x\":1},"
+		"\"tags\":[\"a\",\"b\"],\"pts\":[{\"name\":\"q\",\"x\":2},{\"name\":\"r\",\"x\":3}]}";
+	const char *unterminated="{\"id\":5}garbage";
+	cJSON_Schema *s=cJSON_CompileSchema(record_fields);
+	bound_record r;char *out;
+
+	check(s!=0,"bind: schema compiles");
+	if (!s) return;
+	check(binds_to(s,full,0,1,full),"bind: round trip");
+	check(binds_to(s,"{\"extra\":[1,{\"y\":null}],\"id\":7,\"title\":null}",0,1,
+		"{\"id\":7,\"score\":0,\"ok\":false,\"title\":null,\"code\":\"\",\"at\":{\"name\":\"\",\"x\":0},\"tags\":[],\"pts\":[]}"),"bind: unknown members skipped, null left alone");
+	check(binds_to(s,"{\"tags\":[\"a\",\"b\"],\"tags\":[\"c\"],\"pts\":[{\"x\":1},{\"x\":2}],\"pts\":[{\"x\":3}]}",0,1,
+		"{\"id\":0,\"score\":0,\"ok\":false,\"title\":null,\"code\":\"\",\"at\":{\"name\":\"\",\"x\":0},\"tags\":[\"c\"],\"pts\":[{\"name\":\"\",\"x\":3}]}"),"bind: a repeated list replaces the one before");
+	check(binds_to(s,"{\"tags\":[\"a\",\"b\",\"c\",\"d\"]}",0,0,0),"bind: too many elements fail");
+	check(binds_to(s,"{\"id\":1.5}",0,0,0) && binds_to(s,"{\"id\":3000000000}",0,0,0) && binds_to(s,"{\"id\":-2147483648,\"score\":1.5}",0,1,0),"bind: an int that is fractional or out of range fails");
+	check(binds_to(s,"{\"code\":\"abcd\"}",0,0,0) && binds_to(s,"{\"title\":\"x\",\"id\":\"7\"}",0,0,0),"bind: a string too long, or of the wrong type, fails");
+	check(binds_to(s,unterminated,8,1,"{\"id\":5,\"score\":0,\"ok\":false,\"title\":null,\"code\":\"\",\"at\":{\"name\":\"\",\"x\":0},\"tags\":[],\"pts\":[]}"),"bind: only len bytes are read");
+	check(binds_to(s,unterminated,7,0,0) && binds_to(s,"{\"title\":\"abc\"}",12,0,0) && binds_to(s,unterminated,strlen(unterminated),0,0),"bind: input cut short, or with more after it, fails");
+
+	memset(&r,0,sizeof(r));
+	r.id=-3;r.score=0.125;r.title="x\ny";strcpy(r.code,"z");r.ntags=1;r.tags[0]="\xC3\xA9";r.npts=1;r.pts[0].x=4;
+	out=cJSON_PrintFrom(s,&r);
+	check(out && !strcmp(out,"{\"id\":-3,\"score\":0.125000,\"ok\":false,\"title\":\"x\\ny\",\"code\":\"z\",\"at\":{\"name\":\"\",\"x\":0},\"tags\":[\"\xC3\xA9\"],\"pts\":[{\"name\":\"\",\"x\":4}]}"),"bind: print");
+	free(out);
+	cJSON_DeleteSchema(s);
+}
+
+/* Compiled JSON Pointer queries: a batch finds what each path finds on its own. */
+void query_checks()
+{
+	const char *pointers[]={"","/a/0/b","/a/*/b","/a/1/x~1y","/a/0/c~0d","/a~1b","/~0","/*","/list/*/1","/list/1/0","/list/*/*","/k","/a/5","/a/01","/missing","/a/0/b/c"};
+	int i,n=sizeof(pointers)/sizeof(*pointers),count,ok=1;
+	cJSON *doc=cJSON_Parse("{\"a\":[{\"b\":1,\"c~d\":2},{\"b\":3,\"x/y\":4}],\"a/b\":5,\"~\":6,\"*\":7,\"list\":[[10,11],[12]],\"k\":8,\"k\":9}");
+	cJSON_Path *paths[16];cJSON *batch[16],*found[4];
+
+	for (i=0;i<n;i++) paths[i]=cJSON_CompilePath(pointers[i]);
+	check(cJSON_QueryBatch(doc,paths,n,batch)==12,"query: batch match count");
+	for (i=0;i<n;i++)
+	{
+		count=cJSON_QueryCompiled(doc,paths[i],found,1);
+		if ((count?found[0]:0)!=batch[i]) ok=0;
+		if (!strchr(pointers[i],'*') && batch[i]!=cJSON_GetPointer(doc,pointers[i])) ok=0;
+	}
+	check(ok,"query: batch, compiled and GetPointer agree");
+	check(batch[5]->valueint==5 && batch[6]->valueint==6 && batch[3]->valueint==4 && batch[4]->valueint==2,"query: escaped segments");
+	check(batch[11]->valueint==8 && batch[7]==doc->child,"query: first member of a name, first match of a wildcard");
+	check(cJSON_QueryCompiled(doc,paths[2],found,4)==2 && found[1]->valueint==3,"query: wildcard over an array");
+	check(cJSON_QueryCompiled(doc,paths[10],found,2)==3 && found[1]->valueint==11,"query: wildcards count past max");
+	for (i=0;i<n;i++) cJSON_DeletePath(paths[i]);
+	cJSON_Delete(doc);
+}
+
+/* Statistics add up: what is freed matches what was allocated. Build with make stats to run these. */
+void stats_checks()
+{
+#ifdef CJSON_STATS
+	cJSON_Stats st;cJSON *json,*n;char *out;size_t len;int i;
+	const char *text="{\"a\":[1,2,3],\"b\":\"te\\u0078t\",\"c\":[true,{\"d\":null}]}";
+
+	cJSON_ResetStats();
+	json=cJSON_ParseWithFlags(text,0,cJSON_ParsePackNumbers);
+	cJSON_Delete(json);
+	cJSON_GetStats(&st);
+	check(st.nodes[cJSON_Number]==3 && st.nodes[cJSON_Array]==2 && st.nodes[cJSON_Object]==2,"stats: nodes by type, packed numbers included");
+	check(st.allocs==st.frees && st.alloc_bytes==st.free_bytes,"stats: parse and delete balance");
+
+	cJSON_ResetStats();
+	json=cJSON_Parse(text);
+	out=cJSON_PrintWithOpts(json,cJSON_PrintCached);len=strlen(out);free(out);
+	out=cJSON_Print(json);cJSON_Delete(json);
+	cJSON_GetStats(&st);
+	check(st.allocs==st.frees+2 && st.alloc_bytes-st.free_bytes>=len+1+strlen(out)+1,"stats: only the printed text is outstanding");
+	free(out);
+
+	/* Cached text is kept once, however many arrays/objects it lies under. */
+	json=cJSON_CreateObject();
+	for (i=0;i<20;i++) {n=cJSON_CreateObject();cJSON_AddStringToObject(n,"s","0123456789012345678901234567890123456789012345678901234567890123456789");cJSON_AddItemToObject(n,"n",json);json=n;}
+	cJSON_ResetStats();
+	out=cJSON_PrintWithOpts(json,cJSON_PrintCached);len=strlen(out);free(out);
+	cJSON_GetStats(&st);
+	check(st.alloc_bytes-st.free_bytes<3*len,"stats: cached text is kept once");
+	cJSON_Delete(json);
+
+	json=cJSON_Parse(text);
+	cJSON_ResetStats();
+	cJSON_Delete(json);
+	cJSON_GetStats(&st);
+	check(st.frees>0 && st.free_bytes==0,"stats: blocks from before a reset are freed without their bytes");
+#endif
+}
+
 int main (int argc, const char * argv[]) {
 	/* a bunch of json: */
 	char text1[]="{\n\"name\": \"Jack (\\\"Bee\\\") Nimble\", \n\"format\": {\"type\":       \"rect\", \n\"width\":      1920, \n\"height\":     1080, \n\"interlace\":  false,\"frame rate\": 24\n}\n}";	
@@ -151,6 +489,17 @@ int main (int argc, const char * argv[]) {
 
 	/* Now some samplecode for building objects concisely: */
 	create_objects();
+
+	shared_checks();
+	hash_checks();
+	patch_checks();
+	packed_checks();
+	escape_checks();
+	cache_checks();
+	bind_checks();
+	query_checks();
+	stats_checks();
 	
-	return 0;
+	if (failures) printf("%d checks failed\n",failures);
+	return failures!=0;
 }